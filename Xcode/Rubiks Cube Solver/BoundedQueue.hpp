@@ -0,0 +1,115 @@
+//
+//  BoundedQueue.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef BoundedQueue_hpp
+#define BoundedQueue_hpp
+
+//
+// A bounded, lock-free, multiple producer/multiple consumer queue
+// (after Dmitry Vyukov's array based queue).  Each cell carries a
+// sequence number that tells producers and consumers whether the
+// cell is free to be written or ready to be read, so the only
+// contention is a compare and swap on the enqueue or dequeue
+// position.  Neither operation ever blocks: TryPush fails when
+// the queue is full and TryPop fails when it is empty.
+//
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+template<class Item>
+class BoundedQueue {
+public:
+    // The capacity is rounded up to a power of two
+    BoundedQueue(size_t capacity) : enqueuePosition(0), dequeuePosition(0) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask = size-1;
+        cells = vector<Cell>(size);
+        for (size_t i = 0; i < size; i++)
+            cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    bool TryPush(const Item &item) {
+        size_t position = enqueuePosition.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0) {	// Cell is free, try to claim it
+                if (enqueuePosition.compare_exchange_weak(position, position+1, memory_order_relaxed))
+                    break;
+            } else if (difference < 0) {	// Queue is full
+                return false;
+            } else {			// Another producer got there first
+                position = enqueuePosition.load(memory_order_relaxed);
+            }
+        }
+        Cell& cell = cells[position & mask];
+        cell.item = item;
+        cell.sequence.store(position+1, memory_order_release);
+        return true;
+    }
+
+    bool TryPop(Item &item) {
+        size_t position = dequeuePosition.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position+1);
+            if (difference == 0) {	// Cell is full, try to claim it
+                if (dequeuePosition.compare_exchange_weak(position, position+1, memory_order_relaxed))
+                    break;
+            } else if (difference < 0) {	// Queue is empty
+                return false;
+            } else {			// Another consumer got there first
+                position = dequeuePosition.load(memory_order_relaxed);
+            }
+        }
+        Cell& cell = cells[position & mask];
+        item = cell.item;
+        cell.sequence.store(position+mask+1, memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued items (exact when quiescent)
+    size_t Size(void) const {
+        size_t enqueued = enqueuePosition.load(memory_order_relaxed);
+        size_t dequeued = dequeuePosition.load(memory_order_relaxed);
+        return enqueued > dequeued ? enqueued-dequeued : 0;
+    }
+
+    size_t Capacity(void) const { return mask+1; }
+
+private:
+    struct Cell {
+        Cell(void) : sequence(0) {}
+        Cell(const Cell &cell) : sequence(cell.sequence.load()), item(cell.item) {}
+        atomic<size_t> sequence;
+        Item item;
+    };
+
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+
+    vector<Cell> cells;
+    size_t mask;
+    // Kept on separate cache lines so producers and consumers
+    //   do not slow each other down
+    char pad0[64];
+    atomic<size_t> enqueuePosition;
+    char pad1[64];
+    atomic<size_t> dequeuePosition;
+    char pad2[64];
+};
+
+#endif /* BoundedQueue_hpp */
@@ -19,6 +19,11 @@ Cube::Cube() {
 // Destructor
 Cube::~Cube() {}
 
+// Make a copy of the cube
+Cube* Cube::Clone() const {
+    return new Cube(*this);
+}
+
 // Overloaded equality test operator
 bool Cube::operator==(const Cube &cube) {
     return (
@@ -60,6 +65,19 @@ void Cube::SetState(int *cornerPermutation, int *cornerOrientation, int *edgePer
     }
 }
 
+// Get state as permutation and orientation vectors
+void Cube::GetState(int *cornerPermutation, int *cornerOrientation, int *edgePermutation, int *edgeOrientation) const {
+    int cubie;
+    for (cubie = FirstEdgeCubie; cubie <= LastEdgeCubie; cubie++) {
+        edgePermutation[cubie] = EdgeCubiePermutations[cubie];
+        edgeOrientation[cubie] = EdgeCubieOrientations[cubie];
+    }
+    for (cubie = FirstCornerCubie; cubie <= LastCornerCubie; cubie++) {
+        cornerPermutation[cubie] = CornerCubiePermutations[cubie];
+        cornerOrientation[cubie] = CornerCubieOrientations[cubie];
+    }
+}
+
 // Apply move
 void Cube::ApplyMove(int move) {
     switch(move) {
@@ -83,6 +83,9 @@ public:
     Cube();
     virtual ~Cube();
     
+    // Make a copy of the cube (e.g. one for each thread)
+    virtual Cube* Clone() const;
+    
     // Overloaded operators
     bool operator==(const Cube &cube);
     bool operator!=(const Cube &cube);
@@ -93,6 +96,9 @@ public:
     // Set state from permutation and orientation vectors
     virtual void SetState(int* cornerPermutation, int* cornerOrientation, int* edgePermutation, int* edgeOrientation);
     
+    // Get state as permutation and orientation vectors
+    void GetState(int* cornerPermutation, int* cornerOrientation, int* edgePermutation, int* edgeOrientation) const;
+    
     // Apply move
     virtual void ApplyMove(int move);
     
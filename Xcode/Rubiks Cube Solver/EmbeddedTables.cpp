@@ -0,0 +1,56 @@
+//
+//  EmbeddedTables.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "EmbeddedTables.hpp"
+
+#ifdef EMBEDDED_TABLES
+
+// EMBEDDED_TABLES is the path of the bundle, as a string literal.
+//   The bundle is aligned as it would be when mapped from a file,
+//   so its tables still start on page (and cache line) boundaries.
+#ifdef __APPLE__
+#define EMBEDDED_SECTION ".section __TEXT,__const"
+#define EMBEDDED_SYMBOL(name) "_" #name
+#else
+#define EMBEDDED_SECTION ".section .rodata"
+#define EMBEDDED_SYMBOL(name) #name
+#endif
+
+__asm__(
+        EMBEDDED_SECTION "\n"
+        ".p2align 14\n"
+        ".globl " EMBEDDED_SYMBOL(EmbeddedTablesBegin) "\n"
+        EMBEDDED_SYMBOL(EmbeddedTablesBegin) ":\n"
+        ".incbin \"" EMBEDDED_TABLES "\"\n"
+        ".globl " EMBEDDED_SYMBOL(EmbeddedTablesEnd) "\n"
+        EMBEDDED_SYMBOL(EmbeddedTablesEnd) ":\n"
+        ".text\n"
+        );
+
+extern "C" const unsigned char EmbeddedTablesBegin[];
+extern "C" const unsigned char EmbeddedTablesEnd[];
+
+const void* EmbeddedTables::Bundle(void) {
+    return EmbeddedTablesBegin;
+}
+
+size_t EmbeddedTables::SizeOf(void) {
+    return EmbeddedTablesEnd-EmbeddedTablesBegin;
+}
+
+#else
+
+const void* EmbeddedTables::Bundle(void) {
+    return 0;
+}
+
+size_t EmbeddedTables::SizeOf(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,39 @@
+//
+//  EmbeddedTables.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef EmbeddedTables_hpp
+#define EmbeddedTables_hpp
+
+//
+// A table bundle (see TableBundle.hpp) built into the executable,
+// so that the solver starts without reading or generating any of
+// the tables it holds.
+//
+// The "Table Generator" target is the solver itself, built without
+// any tables.  Before the solver is compiled, a build phase runs it
+// with -generate to write the default set of move mapping and
+// pruning tables to a bundle, and EMBEDDED_TABLES is defined as the
+// path of that bundle.  The bundle is then assembled into the
+// read-only data of the executable.  The optional tables are far
+// larger, and are still loaded from (or generated into) the bundle
+// file when they are asked for.
+//
+// Without EMBEDDED_TABLES there is no embedded bundle.
+//
+
+#include <cstddef>
+
+class EmbeddedTables {
+public:
+    // The embedded bundle, or 0 if there is none
+    static const void* Bundle(void);
+    // Its size in bytes
+    static size_t SizeOf(void);
+};
+
+#endif /* EmbeddedTables_hpp */
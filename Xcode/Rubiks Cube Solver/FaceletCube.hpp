@@ -168,6 +168,9 @@ private:
     int edgeCubieOrientations[Cube::NumberOfEdgeCubies];
     
     static string errorText[NumberOfErrors];
+    
+    // Symmetry derives its tables from the facelet layout
+    friend class Symmetry;
 };
 
 
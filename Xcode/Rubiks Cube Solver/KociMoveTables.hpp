@@ -13,7 +13,9 @@
 // Subclasses of "MoveTable" for each of the Kociemba
 // move mapping tables.  Functions for converting between
 // an ordinal and its associated cube state are specified
-// for each class via overrides.
+// for each class via overrides.  The phase 1 coordinates
+// are simple enough that their transitions are computed
+// directly from the ordinal instead.
 //
 
 #include "MoveTable.hpp"
@@ -24,42 +26,51 @@
 class TwistMoveTable : public MoveTable {
 public:
     TwistMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::Twists, 0),
-		  TheCube(cube) {}
+    : MoveTable(cube, RubiksCube::Twists, 0) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.Twist(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.Twist(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).Twist(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).Twist(ordinal); }
+    void GenerateRange(int begin, int end) {
+        for (int ordinal = begin; ordinal < end; ordinal++)
+            for (int move = Cube::Move::R; move <= Cube::Move::B; move++)
+                (*this)[ordinal][move] = RubiksCube::TwistAfterMove(ordinal, move);
+    }
 };
 
 class FlipMoveTable : public MoveTable
 {
 public:
     FlipMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::Flips, 0),
-		  TheCube(cube) {}
+    : MoveTable(cube, RubiksCube::Flips, 0) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.Flip(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.Flip(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).Flip(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).Flip(ordinal); }
+    void GenerateRange(int begin, int end) {
+        for (int ordinal = begin; ordinal < end; ordinal++)
+            for (int move = Cube::Move::R; move <= Cube::Move::B; move++)
+                (*this)[ordinal][move] = RubiksCube::FlipAfterMove(ordinal, move);
+    }
 };
 
 class ChoiceMoveTable : public MoveTable
 {
 public:
     ChoiceMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::Choices, 0),
-		  TheCube(cube) {}
+    : MoveTable(cube, RubiksCube::Choices, 0) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.Choice(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.Choice(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).Choice(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).Choice(ordinal); }
+    void GenerateRange(int begin, int end) {
+        for (int ordinal = begin; ordinal < end; ordinal++)
+            for (int move = Cube::Move::R; move <= Cube::Move::B; move++)
+                (*this)[ordinal][move] = RubiksCube::ChoiceAfterMove(ordinal, move);
+    }
 };
 
 // Phase 2 move mapping table classes
@@ -68,42 +79,63 @@ class CornerPermutationMoveTable : public MoveTable
 {
 public:
     CornerPermutationMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::CornerPermutations, 1),
-		  TheCube(cube) {}
+    : MoveTable(cube, RubiksCube::CornerPermutations, 1) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.CornerPermutation(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.CornerPermutation(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).CornerPermutation(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).CornerPermutation(ordinal); }
 };
 
 class NonMiddleSliceEdgePermutationMoveTable : public MoveTable
 {
 public:
     NonMiddleSliceEdgePermutationMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::NonMiddleSliceEdgePermutations, 1),
-		  TheCube(cube) {}
+    : MoveTable(cube, RubiksCube::NonMiddleSliceEdgePermutations, 1) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.NonMiddleSliceEdgePermutation(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.NonMiddleSliceEdgePermutation(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).NonMiddleSliceEdgePermutation(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).NonMiddleSliceEdgePermutation(ordinal); }
 };
 
 class MiddleSliceEdgePermutationMoveTable : public MoveTable
 {
 public:
     MiddleSliceEdgePermutationMoveTable(RubiksCube& cube)
-    : MoveTable(cube, RubiksCube::MiddleSliceEdgePermutations, 1),
-		  TheCube(cube)	{}
+    : MoveTable(cube, RubiksCube::MiddleSliceEdgePermutations, 1) {}
 private:
-    inline int  OrdinalFromCubeState(void)
-    { return TheCube.MiddleSliceEdgePermutation(); }
-    inline void OrdinalToCubeState(int ordinal)
-    { TheCube.MiddleSliceEdgePermutation(ordinal); }
-    RubiksCube& TheCube;
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).MiddleSliceEdgePermutation(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).MiddleSliceEdgePermutation(ordinal); }
+};
+
+// Full group move mapping table classes, which carry the phase 2
+//   coordinates through phase 1 (see Solver::Phase1Solved)
+
+class Phase1CornerPermutationMoveTable : public MoveTable
+{
+public:
+    Phase1CornerPermutationMoveTable(RubiksCube& cube)
+    : MoveTable(cube, RubiksCube::CornerPermutations, 0) {}
+private:
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).CornerPermutation(); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).CornerPermutation(ordinal); }
+};
+
+class EdgeQuadrupleMoveTable : public MoveTable
+{
+public:
+    EdgeQuadrupleMoveTable(RubiksCube& cube)
+    : MoveTable(cube, RubiksCube::EdgeQuadruples, 0) {}
+private:
+    inline int  OrdinalFromCubeState(Cube& cube)
+    { return static_cast<RubiksCube&>(cube).EdgeQuadruple(RubiksCube::UpperEdges); }
+    inline void OrdinalToCubeState(Cube& cube, int ordinal)
+    { static_cast<RubiksCube&>(cube).EdgeQuadruple(RubiksCube::UpperEdges, ordinal); }
 };
 
 #endif /* KociMoveTables_hpp */
@@ -0,0 +1,72 @@
+//
+//  MappedFile.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(void) : Data(0), Size(0) {}
+    
+MappedFile::~MappedFile() {
+    Close();
+}
+
+// The madvise() advice for an access pattern
+static int AdviceFor(MappedFile::Access access) {
+    switch (access) {
+        case MappedFile::Sequential:	return MADV_SEQUENTIAL;
+        case MappedFile::Random:	return MADV_RANDOM;
+        default:			return MADV_WILLNEED;
+    }
+}
+
+bool MappedFile::Open(const char* fileName, size_t expectedSize, Access access) {
+    struct stat status;
+    void* data;
+    
+    Close();
+    
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+        return false;
+    
+    // A truncated (or otherwise stale) file is as good as no file
+    if (fstat(file, &status) != 0 || status.st_size == 0 ||
+        (expectedSize != 0 && (size_t)status.st_size != expectedSize)) {
+        close(file);
+        return false;
+    }
+    expectedSize = status.st_size;
+    
+    data = mmap(0, expectedSize, PROT_READ, MAP_SHARED, file, 0);
+    close(file);	// The mapping keeps its own reference to the file
+    if (data == MAP_FAILED)
+        return false;
+    
+    (void)madvise(data, expectedSize, AdviceFor(access));
+    
+    Data = data;
+    Size = expectedSize;
+    return true;
+}
+
+void MappedFile::Advise(size_t offset, size_t size, Access access) {
+    if (Data && offset < Size)
+        (void)madvise((char*)Data+offset, size < Size-offset ? size : Size-offset, AdviceFor(access));
+}
+
+void MappedFile::Close(void) {
+    if (Data) {
+        munmap(Data, Size);
+        Data = 0;
+        Size = 0;
+    }
+}
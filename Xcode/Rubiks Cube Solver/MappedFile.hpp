@@ -0,0 +1,58 @@
+//
+//  MappedFile.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+//
+// A read-only memory mapping of a table file.  The search indexes
+// straight into the mapped pages, so loading a table costs next to
+// nothing and every process using the same file shares a single
+// copy of it in the page cache.
+//
+
+#include <cstddef>
+
+class MappedFile {
+public:
+    // How the mapped table will be accessed
+    enum Access {
+        Sequential,	// Read front to back (read ahead aggressively)
+        Random,		// Scattered lookups (don't bother reading ahead)
+        Hot		// Small and used constantly (fault it all in now)
+    };
+
+    MappedFile(void);
+    ~MappedFile();
+
+    // Map a file, which must be exactly expectedSize bytes long
+    //   (or of any size but empty, when expectedSize is 0).
+    //   Returns false (and maps nothing) if the file is absent or
+    //   has the wrong size.
+    bool Open(const char* fileName, size_t expectedSize, Access access);
+    
+    // Change the expected access for part of the file, which must
+    //   begin on a page boundary
+    void Advise(size_t offset, size_t size, Access access);
+
+    // Unmap the file
+    void Close(void);
+
+    bool IsOpen(void) const { return Data != 0; }
+    const void* Address(void) const { return Data; }
+    size_t SizeOf(void) const { return Size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    void* Data;
+    size_t Size;
+};
+
+#endif /* MappedFile_hpp */
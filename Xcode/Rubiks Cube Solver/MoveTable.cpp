@@ -8,50 +8,79 @@
 
 #include "MoveTable.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "ThreadPool.hpp"
 
 using namespace std;
 
 MoveTable::MoveTable(Cube& cube, int tableSize, int phase2)
-: TheCube(cube), TableSize(tableSize), Phase2(phase2) {
-    // Allocate table storage
-    Table = (int (*)[Cube::Move::NumberOfClockwiseQuarterTurnMoves]) // the cast
-    (new int[TableSize*Cube::Move::NumberOfClockwiseQuarterTurnMoves]); // the allocation
+: TheCube(cube), TableSize(tableSize), Phase2(phase2), Table(0), Storage(0) {
 }
 
 MoveTable::~MoveTable() {
-    delete [] Table;
+    free(Storage);
 }
 
-void MoveTable::Initialize(char* fileName) {
-    ifstream infile(fileName, ios::in|ios::binary);
-    if (!infile) {	// If the move mapping table file is absent...
-        // Generate the table and save it to a file
-        cout << "Generating" << endl;
+bool MoveTable::Initialize(const void* image) {
+    if (!image) {
+        // There is no saved move mapping table...
+        // Generate the table (the caller saves it)
         Generate();
-        cout << "Saving" << endl;
-        Save(fileName);
-        cout << "Done Saving" << endl;
-    } else { // The move mapping table file exists
-        // Load the existing file
-        cout << "Loading" << endl;
-        Load(infile);
+        return false;
     }
+    // Index straight into the saved image
+    Table = (uint16_t (*)[RowSize])image;
+    return true;
 }
 
 // Generate the table
 void MoveTable::Generate() {
     int ordinal;
+    
+    // Allocate table storage, with the padding cleared so
+    //   that the saved image does not depend on the heap
+    if (!Storage && posix_memalign(&Storage, RowAlignment, ImageSize()) != 0)
+        throw bad_alloc();
+    memset(Storage, 0, ImageSize());
+    Table = (uint16_t (*)[RowSize])Storage;
+    
+    // Split the ordinals into ranges and generate them in parallel
+    ThreadPool pool;
+    int numberOfRanges = pool.Size()*RangesPerThread;
+    int rangeSize = max((TableSize+numberOfRanges-1)/numberOfRanges, (int)MinimumRangeSize);
+    vector<future<void> > ranges;
+    for (ordinal = 0; ordinal < TableSize; ordinal += rangeSize) {
+        int begin = ordinal;
+        int end = min(ordinal+rangeSize, TableSize);
+        ranges.push_back(pool.Submit([this, begin, end]() { GenerateRange(begin, end); }));
+    }
+    for (size_t range = 0; range < ranges.size(); range++)
+        ranges[range].get();
+}
+
+void MoveTable::GenerateRange(int begin, int end) {
+    int ordinal;
     int move, move2;
     
+    // A private copy of the cube for this range
+    unique_ptr<Cube> cube(TheCube.Clone());
+    
     // Insure the cubies are in their proper slice
-    TheCube.BackToHome();
+    cube->BackToHome();
     
     // Initialize each table entry
-    for (ordinal = 0; ordinal < TableSize; ordinal++) {
+    for (ordinal = begin; ordinal < end; ordinal++) {
         // Establish the proper cube state for the current ordinal
-        OrdinalToCubeState(ordinal);
+        OrdinalToCubeState(*cube, ordinal);
         
         // Initialize the possible moves for each entry
         for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
@@ -63,32 +92,20 @@ void MoveTable::Generate() {
             if (Phase2 && move != Cube::Move::U && move != Cube::Move::D)
                 move2 = Cube::QuarterTurnToHalfTurnMove(move);
             
-            TheCube.ApplyMove(move2);
+            cube->ApplyMove(move2);
             
             // Compute a new ordinal from the new cube state
-            Table[ordinal][move] = OrdinalFromCubeState();
+            Table[ordinal][move] = OrdinalFromCubeState(*cube);
             // Unapply this move
-            TheCube.ApplyMove(Cube::InverseOfMove(move2));
+            cube->ApplyMove(Cube::InverseOfMove(move2));
         }
     }
 }
 
-int* MoveTable::operator[](int index) {
+uint16_t* MoveTable::operator[](int index) {
     return Table[index];
 }
 
-void MoveTable::Save(char* fileName) {
-    ofstream outfile(fileName, ios::out|ios::binary);
-    int index;
-    for (index = 0; index < TableSize; index++)
-        outfile.write((char*)&Table[index], Cube::Move::NumberOfClockwiseQuarterTurnMoves*sizeof(int));
-}
-
-void MoveTable::Load(ifstream &infile) {
-    for(int index = 0; index < TableSize; index++)
-        infile.read((char*)&Table[index], Cube::Move::NumberOfClockwiseQuarterTurnMoves*sizeof(int));
-}
-
 // Output the move table in human readable form
 void MoveTable::Dump() {
     int ordinal;
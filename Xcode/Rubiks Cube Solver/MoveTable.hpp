@@ -9,12 +9,28 @@
 #ifndef MoveTable_hpp
 #define MoveTable_hpp
 
-#include "Cube.hpp"
+#include <cstdint>
 
-#include <fstream>
+#include "Cube.hpp"
 
 using namespace std;
 
+// A read-only view of a move table for the search.  Every ordinal
+//   fits in 16 bits, and each row of six entries is padded to
+//   eight so that four rows fill a cache line exactly.  Lookups
+//   are a plain index calculation, with no virtual call.
+class MoveTableView final {
+public:
+    enum { RowSize = 8 };	// Entries per row, including padding
+    
+    MoveTableView(const uint16_t* rows = 0) : Rows(rows) {}
+    
+    const uint16_t* operator[](int index) const { return Rows+index*RowSize; }
+    
+private:
+    const uint16_t* Rows;
+};
+
 class MoveTable {
 public:
     // The constructor must be provided with a cube to be
@@ -27,16 +43,28 @@ public:
     
     virtual ~MoveTable();
     
-    // Initialize the pruning table by either generating it
-    //   or loading it from an existing file
-    virtual void Initialize(char* fileName);
+    // Initialize the move table by either using a saved image
+    //   of it (see TableBundle.hpp), if there is one, or
+    //   generating it.  Returns whether the image was used.
+    virtual bool Initialize(const void* image);
+    
+    // The table's contents, to be saved
+    const void* Image(void) const { return Table; }
+    // Size of the table in bytes
+    //   (images saved in any other layout are simply regenerated)
+    size_t ImageSize(void) const {
+        return TableSize*RowSize*sizeof(uint16_t);
+    }
     
     // Overloaded subscript operator allows standard C++ indexing
     //   (i.e. MoveTable[i][j]) for accessing table values.
-    virtual int* operator[](int index);
+    virtual uint16_t* operator[](int index);
+    
+    // Read-only view of the table used by the search
+    MoveTableView View(void) const { return MoveTableView(Table[0]); }
     
     // Obtain the size of the table (number of logical entries)
-    virtual int SizeOf() { return TableSize; }
+    virtual int SizeOf() const { return TableSize; }
     
     // Dump table contents
     virtual void Dump();
@@ -45,24 +73,36 @@ protected:
     // These functions must be overloaded in the derived
     //   class in order to provide the appropriate mapping
     //   between ordinal and cube state.
-    virtual int OrdinalFromCubeState() = 0;
-    virtual void OrdinalToCubeState(int ordinal) = 0;
+    virtual int OrdinalFromCubeState(Cube& cube) = 0;
+    virtual void OrdinalToCubeState(Cube& cube, int ordinal) = 0;
+    
+    // Compute the table entries for the ordinals in [begin, end).
+    //   By default each move is applied to the cubies of a private
+    //   copy of the cube, so that ranges can be generated in
+    //   parallel.  Derived classes may instead compute the
+    //   transitions directly from the ordinal.
+    virtual void GenerateRange(int begin, int end);
     
 private:
+    enum {
+        RowSize = MoveTableView::RowSize,	// Entries per row, including padding
+        RowAlignment = 64,		// Rows are packed into cache lines from here
+        RangesPerThread = 8,		// Work units per generation thread
+        MinimumRangeSize = 256		// Smallest range worth handing to a thread
+    };
+    
     // Generate the table
     void Generate();
-    // Save the table to a file
-    void Save(char* fileName);
-    // Load the table from a file
-    void Load(ifstream& infile);
     
     // Copies of important variables
     Cube& TheCube;
     // Number of entries in the pruning table
     int TableSize;
     int Phase2;
-    // The table pointer
-    int (*Table)[Cube::Move::NumberOfClockwiseQuarterTurnMoves];
+    // The table pointer (into either Storage or a saved image)
+    uint16_t (*Table)[RowSize];
+    // Heap storage for a generated table (cache line aligned)
+    void* Storage;
 };
 
 
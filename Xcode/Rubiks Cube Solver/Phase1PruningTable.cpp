@@ -0,0 +1,185 @@
+//
+//  Phase1PruningTable.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "Phase1PruningTable.hpp"
+
+#include <stdexcept>
+
+#include "RubiksCube.hpp"
+
+using namespace std;
+
+// The table index of the cube's "home" configuration
+static int HomePhase1Index(void) {
+    RubiksCube cube;
+    return Phase1PruningTable::Index(cube.Twist(), cube.Flip()*RubiksCube::Choices+cube.Choice());
+}
+
+Phase1PruningTable::Phase1PruningTable(MoveTable& twistMoveTable, MoveTable& flipMoveTable, MoveTable& choiceMoveTable)
+: PruningTable(Symmetry::FlipSliceClasses*Symmetry::Twists, HomePhase1Index(), DistanceMod3),
+TwistMoveTable(twistMoveTable), FlipMoveTable(flipMoveTable), ChoiceMoveTable(choiceMoveTable) {
+}
+
+// Walk down to the goal, one move at a time, to find the exact
+//   distance of a position: there is always a neighbour one move
+//   closer, and it is the only neighbour whose entry is one less
+//   (modulo 3).  A table that breaks this (one generated by another
+//   version, say) would walk forever, so the walk is cut short.
+int Phase1PruningTable::Distance(int twist, int flipSlice) const {
+    int distance = 0;
+    int flip = flipSlice/RubiksCube::Choices;
+    int choice = flipSlice%RubiksCube::Choices;
+    int index = Index(twist, flipSlice);
+    MoveTableView twistMoves = TwistMoveTable.View();
+    MoveTableView flipMoves = FlipMoveTable.View();
+    MoveTableView choiceMoves = ChoiceMoveTable.View();
+    
+    while (index != HomeIndex) {
+        if (distance == MaxDistance)
+            throw runtime_error("Phase1PruningTable is corrupt");
+        unsigned int closer = (GetValue(index)+2)%3;
+        bool found = false;
+        for (int move = Cube::Move::R; move <= Cube::Move::B && !found; move++) {
+            int twist2 = twist, flip2 = flip, choice2 = choice;
+            for (int power = 1; power < 4 && !found; power++) {
+                twist2 = twistMoves[twist2][move];
+                flip2 = flipMoves[flip2][move];
+                choice2 = choiceMoves[choice2][move];
+                int index2 = Index(twist2, flip2*RubiksCube::Choices+choice2);
+                if (GetValue(index2) == closer) {
+                    twist = twist2;
+                    flip = flip2;
+                    choice = choice2;
+                    index = index2;
+                    found = true;
+                }
+            }
+        }
+        distance++;
+    }
+    return distance;
+}
+
+// Expand the frontier entries within [begin, end), returning
+//   the number of new nodes found
+long Phase1PruningTable::SearchForward(int begin, int end, unsigned int depth,
+                                       const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int twist, flip, choice;	// Coordinates of the representative
+    int twist2, flip2, choice2;	// Coordinates of the child
+    int twist3;			// Twist of the child's conjugate
+    int flipSlice, flipSliceClass, symmetry;
+    int index, index2;		// Table indices
+    unsigned int stabilizer;
+    int word;
+    uint64_t bits;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView twistMoves = TwistMoveTable.View();
+    MoveTableView flipMoves = FlipMoveTable.View();
+    MoveTableView choiceMoves = ChoiceMoveTable.View();
+    
+    // Visit each entry corresponding to the current depth
+    for (word = begin/64; word < (end+63)/64; word++) {
+        for (bits = frontier[word]; bits; bits &= bits-1) {
+            index = word*64+__builtin_ctzll(bits);
+            flipSlice = Symmetry::FlipSliceRepresentative(index/Symmetry::Twists);
+            twist = index%Symmetry::Twists;
+            flip = flipSlice/RubiksCube::Choices;
+            choice = flipSlice%RubiksCube::Choices;
+            // Apply each possible move
+            for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
+                twist2 = twist;
+                flip2 = flip;
+                choice2 = choice;
+                // Apply each of the three quarter turns
+                for (power = 1; power < 4; power++) {
+                    twist2 = twistMoves[twist2][move];
+                    flip2 = flipMoves[flip2][move];
+                    choice2 = choiceMoves[choice2][move];
+                    flipSlice = flip2*RubiksCube::Choices+choice2;
+                    flipSliceClass = Symmetry::FlipSliceClass(flipSlice);
+                    twist3 = Symmetry::ConjugateTwist(twist2, Symmetry::FlipSliceSymmetry(flipSlice));
+                    index2 = flipSliceClass*Symmetry::Twists+twist3;
+    
+                    // Update previously unexplored nodes only
+                    if (!SetValueIfEmpty(index2, value))
+                        continue;
+                    __atomic_fetch_or(&next[index2/64], (uint64_t)1<<(index2%64), __ATOMIC_RELAXED);
+                    numberOfNodes++;
+    
+                    // Along with the other entries for the same position
+                    //   (bit 0 of the stabilizer is the identity)
+                    stabilizer = Symmetry::FlipSliceStabilizer(flipSliceClass);
+                    for (symmetry = 1; stabilizer >>= 1; symmetry++) {
+                        if (!(stabilizer&1))
+                            continue;
+                        index2 = flipSliceClass*Symmetry::Twists+Symmetry::ConjugateTwist(twist3, symmetry);
+                        if (SetValueIfEmpty(index2, value)) {
+                            __atomic_fetch_or(&next[index2/64], (uint64_t)1<<(index2%64), __ATOMIC_RELAXED);
+                            numberOfNodes++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return numberOfNodes;
+}
+
+// Fill the empty entries within [begin, end) that have a
+//   neighbour in the frontier, returning the number of new
+//   nodes found
+long Phase1PruningTable::SearchBackward(int begin, int end, unsigned int depth,
+                                        const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int twist, flip, choice;	// Coordinates of the representative
+    int twist2, flip2, choice2;	// Coordinates of the neighbour
+    int flipSlice;
+    int index, index2;		// Table indices
+    bool found;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView twistMoves = TwistMoveTable.View();
+    MoveTableView flipMoves = FlipMoveTable.View();
+    MoveTableView choiceMoves = ChoiceMoveTable.View();
+    
+    // Scan the empty entries only
+    for (index = begin; index < end; index++) {
+        if (!IsEmpty(index))
+            continue;
+        flipSlice = Symmetry::FlipSliceRepresentative(index/Symmetry::Twists);
+        twist = index%Symmetry::Twists;
+        flip = flipSlice/RubiksCube::Choices;
+        choice = flipSlice%RubiksCube::Choices;
+        found = false;
+        // Apply each possible move until a neighbour in the frontier turns up
+        for (move = Cube::Move::R; move <= Cube::Move::B && !found; move++) {
+            twist2 = twist;
+            flip2 = flip;
+            choice2 = choice;
+            // Apply each of the three quarter turns
+            for (power = 1; power < 4 && !found; power++) {
+                twist2 = twistMoves[twist2][move];
+                flip2 = flipMoves[flip2][move];
+                choice2 = choiceMoves[choice2][move];
+                index2 = Index(twist2, flip2*RubiksCube::Choices+choice2);
+                found = (frontier[index2/64]>>(index2%64))&1;
+            }
+        }
+        // This range owns the entry, so no other thread will touch it
+        if (found) {
+            SetValue(index, value);
+            next[index/64] |= (uint64_t)1<<(index%64);
+            numberOfNodes++;
+        }
+    }
+    return numberOfNodes;
+}
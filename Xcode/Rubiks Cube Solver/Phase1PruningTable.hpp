@@ -0,0 +1,75 @@
+//
+//  Phase1PruningTable.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef Phase1PruningTable_hpp
+#define Phase1PruningTable_hpp
+
+//
+// A pruning table over the complete phase 1 coordinate, rather
+// than over a pair of its three parts.  Its entries are therefore
+// the exact number of moves needed to finish phase 1.
+//
+// Twist*FlipSlice is far too large a table (over two billion
+// entries), but the FlipSlice coordinate can be reduced by the 16
+// symmetries preserving the U-D axis to one of 64430 classes (see
+// Symmetry.hpp).  Conjugating a position by such a symmetry does
+// not change its distance from the phase 1 goal, so the table is
+// indexed by FlipSlice class and the twist of the conjugate that
+// takes the flip and slice to the class representative.
+//
+// A representative may be left unchanged by some symmetries,
+// in which case one position has several entries.  The search
+// fills all of them together.
+//
+// Entries hold the distance modulo 3 (see PruningTable.hpp), so
+// the table takes 35 MB.
+//
+
+#include "MoveTable.hpp"
+#include "PruningTable.hpp"
+#include "Symmetry.hpp"
+
+class Phase1PruningTable : public PruningTable {
+public:
+    enum { MaxDistance = 12 };	// No position is further from the phase 1 goal
+    
+    // Constructor - Must provide the twist, flip and choice move
+    //   mapping tables
+    Phase1PruningTable(MoveTable& twistMoveTable, MoveTable& flipMoveTable, MoveTable& choiceMoveTable);
+    
+    // The number of moves needed to complete phase 1, where
+    //   flipSlice = flip*Choices+choice.  Finding it takes a walk
+    //   to the goal, so the search should only do so at the root.
+    //   Throws runtime_error if the walk does not reach the goal
+    //   within MaxDistance moves, as only a corrupt table allows.
+    int Distance(int twist, int flipSlice) const;
+    // The same for a neighbour of a position neighbourDistance
+    //   moves away, which takes a single lookup
+    int Distance(int twist, int flipSlice, int neighbourDistance) const {
+        return NeighbourDistance(neighbourDistance, GetValue(Index(twist, flipSlice)));
+    }
+    
+    // The table index of a phase 1 position
+    static int Index(int twist, int flipSlice) {
+        return Symmetry::FlipSliceClass(flipSlice)*Symmetry::Twists
+        + Symmetry::ConjugateTwist(twist, Symmetry::FlipSliceSymmetry(flipSlice));
+    }
+    
+protected:
+    long SearchForward(int begin, int end, unsigned int depth,
+                       const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    long SearchBackward(int begin, int end, unsigned int depth,
+                        const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    
+private:
+    MoveTable& TwistMoveTable;
+    MoveTable& FlipMoveTable;
+    MoveTable& ChoiceMoveTable;
+};
+
+#endif /* Phase1PruningTable_hpp */
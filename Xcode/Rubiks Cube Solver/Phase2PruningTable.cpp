@@ -0,0 +1,168 @@
+//
+//  Phase2PruningTable.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "Phase2PruningTable.hpp"
+
+#include <stdexcept>
+
+#include "RubiksCube.hpp"
+
+using namespace std;
+
+// The table index of the cube's "home" configuration
+static int HomePhase2Index(void) {
+    RubiksCube cube;
+    return Phase2PruningTable::Index(cube.CornerPermutation(), cube.NonMiddleSliceEdgePermutation());
+}
+
+Phase2PruningTable::Phase2PruningTable(MoveTable& cornerPermutationMoveTable, MoveTable& nonMiddleSliceEdgePermutationMoveTable)
+: PruningTable(Symmetry::CornerPermutationClasses*Symmetry::NonMiddleSliceEdgePermutations, HomePhase2Index(), DistanceMod3),
+CornerPermutationMoveTable(cornerPermutationMoveTable), NonMiddleSliceEdgePermutationMoveTable(nonMiddleSliceEdgePermutationMoveTable) {
+}
+
+// Walk down to the goal to find the exact distance of a
+//   position (as in Phase1PruningTable::Distance)
+int Phase2PruningTable::Distance(int cornerPermutation, int nonMiddleSliceEdgePermutation) const {
+    int distance = 0;
+    int index = Index(cornerPermutation, nonMiddleSliceEdgePermutation);
+    MoveTableView cornerMoves = CornerPermutationMoveTable.View();
+    MoveTableView edgeMoves = NonMiddleSliceEdgePermutationMoveTable.View();
+    
+    while (index != HomeIndex) {
+        if (distance == MaxDistance)
+            throw runtime_error("Phase2PruningTable is corrupt");
+        unsigned int closer = (GetValue(index)+2)%3;
+        bool found = false;
+        for (int move = Cube::Move::R; move <= Cube::Move::B && !found; move++) {
+            int corner2 = cornerPermutation, edge2 = nonMiddleSliceEdgePermutation;
+            for (int power = 1; power < 4 && !found; power++) {
+                corner2 = cornerMoves[corner2][move];
+                edge2 = edgeMoves[edge2][move];
+                int index2 = Index(corner2, edge2);
+                if (GetValue(index2) == closer) {
+                    cornerPermutation = corner2;
+                    nonMiddleSliceEdgePermutation = edge2;
+                    index = index2;
+                    found = true;
+                }
+            }
+        }
+        distance++;
+    }
+    return distance;
+}
+
+// Expand the frontier entries within [begin, end), returning
+//   the number of new nodes found
+long Phase2PruningTable::SearchForward(int begin, int end, unsigned int depth,
+                                       const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int corner, edge;		// Coordinates of the representative
+    int corner2, edge2;		// Coordinates of the child
+    int edge3;			// Edges of the child's conjugate
+    int cornerClass, symmetry;
+    int index, index2;		// Table indices
+    unsigned int stabilizer;
+    int word;
+    uint64_t bits;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView cornerMoves = CornerPermutationMoveTable.View();
+    MoveTableView edgeMoves = NonMiddleSliceEdgePermutationMoveTable.View();
+    
+    // Visit each entry corresponding to the current depth
+    for (word = begin/64; word < (end+63)/64; word++) {
+        for (bits = frontier[word]; bits; bits &= bits-1) {
+            index = word*64+__builtin_ctzll(bits);
+            corner = Symmetry::CornerPermutationRepresentative(index/Symmetry::NonMiddleSliceEdgePermutations);
+            edge = index%Symmetry::NonMiddleSliceEdgePermutations;
+            // Apply each possible move
+            for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
+                corner2 = corner;
+                edge2 = edge;
+                // Apply each of the three quarter turns (the
+                //   R, L, F and B entries are half turns, so the
+                //   second of those leads back to the parent)
+                for (power = 1; power < 4; power++) {
+                    corner2 = cornerMoves[corner2][move];
+                    edge2 = edgeMoves[edge2][move];
+                    cornerClass = Symmetry::CornerPermutationClass(corner2);
+                    edge3 = Symmetry::ConjugateNonMiddleSliceEdgePermutation(edge2, Symmetry::CornerPermutationSymmetry(corner2));
+                    index2 = cornerClass*Symmetry::NonMiddleSliceEdgePermutations+edge3;
+    
+                    // Update previously unexplored nodes only
+                    if (!SetValueIfEmpty(index2, value))
+                        continue;
+                    __atomic_fetch_or(&next[index2/64], (uint64_t)1<<(index2%64), __ATOMIC_RELAXED);
+                    numberOfNodes++;
+    
+                    // Along with the other entries for the same position
+                    //   (bit 0 of the stabilizer is the identity)
+                    stabilizer = Symmetry::CornerPermutationStabilizer(cornerClass);
+                    for (symmetry = 1; stabilizer >>= 1; symmetry++) {
+                        if (!(stabilizer&1))
+                            continue;
+                        index2 = cornerClass*Symmetry::NonMiddleSliceEdgePermutations
+                        + Symmetry::ConjugateNonMiddleSliceEdgePermutation(edge3, symmetry);
+                        if (SetValueIfEmpty(index2, value)) {
+                            __atomic_fetch_or(&next[index2/64], (uint64_t)1<<(index2%64), __ATOMIC_RELAXED);
+                            numberOfNodes++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return numberOfNodes;
+}
+
+// Fill the empty entries within [begin, end) that have a
+//   neighbour in the frontier, returning the number of new
+//   nodes found
+long Phase2PruningTable::SearchBackward(int begin, int end, unsigned int depth,
+                                        const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int corner, edge;		// Coordinates of the representative
+    int corner2, edge2;		// Coordinates of the neighbour
+    int index, index2;		// Table indices
+    bool found;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView cornerMoves = CornerPermutationMoveTable.View();
+    MoveTableView edgeMoves = NonMiddleSliceEdgePermutationMoveTable.View();
+    
+    // Scan the empty entries only
+    for (index = begin; index < end; index++) {
+        if (!IsEmpty(index))
+            continue;
+        corner = Symmetry::CornerPermutationRepresentative(index/Symmetry::NonMiddleSliceEdgePermutations);
+        edge = index%Symmetry::NonMiddleSliceEdgePermutations;
+        found = false;
+        // Apply each possible move until a neighbour in the frontier turns up
+        for (move = Cube::Move::R; move <= Cube::Move::B && !found; move++) {
+            corner2 = corner;
+            edge2 = edge;
+            // Apply each of the three quarter turns
+            for (power = 1; power < 4 && !found; power++) {
+                corner2 = cornerMoves[corner2][move];
+                edge2 = edgeMoves[edge2][move];
+                index2 = Index(corner2, edge2);
+                found = (frontier[index2/64]>>(index2%64))&1;
+            }
+        }
+        // This range owns the entry, so no other thread will touch it
+        if (found) {
+            SetValue(index, value);
+            next[index/64] |= (uint64_t)1<<(index%64);
+            numberOfNodes++;
+        }
+    }
+    return numberOfNodes;
+}
@@ -0,0 +1,68 @@
+//
+//  Phase2PruningTable.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef Phase2PruningTable_hpp
+#define Phase2PruningTable_hpp
+
+//
+// A pruning table over the complete phase 2 corner and edge
+// permutations, leaving out only the middle slice edges.
+//
+// CornerPermutation*NonMiddleSliceEdgePermutation is too large
+// a table (8!*8! entries), but the corner permutation can be
+// reduced by the 16 symmetries preserving the U-D axis to one of
+// 2768 classes (see Symmetry.hpp), which leaves 111 million
+// entries.  As in Phase1PruningTable, the table is indexed by
+// class and the edge permutation of the conjugate that takes the
+// corners to the class representative, and positions whose
+// representative is left unchanged by some symmetries have
+// several entries.  Entries hold the distance modulo 3, which
+// takes 28 MB.
+//
+
+#include "MoveTable.hpp"
+#include "PruningTable.hpp"
+#include "Symmetry.hpp"
+
+class Phase2PruningTable : public PruningTable {
+public:
+    enum { MaxDistance = 18 };	// No phase 2 position is further from the goal
+    
+    // Constructor - Must provide the phase 2 corner and (non middle
+    //   slice) edge permutation move mapping tables
+    Phase2PruningTable(MoveTable& cornerPermutationMoveTable, MoveTable& nonMiddleSliceEdgePermutationMoveTable);
+    
+    // The number of moves needed to solve the corners and the U
+    //   and D layer edges (a lower bound on the number needed to
+    //   complete phase 2).  As in Phase1PruningTable, the search
+    //   should only call the first at the root, which throws
+    //   runtime_error if the table is corrupt.
+    int Distance(int cornerPermutation, int nonMiddleSliceEdgePermutation) const;
+    int Distance(int cornerPermutation, int nonMiddleSliceEdgePermutation, int neighbourDistance) const {
+        return NeighbourDistance(neighbourDistance, GetValue(Index(cornerPermutation, nonMiddleSliceEdgePermutation)));
+    }
+    
+    // The table index of a phase 2 position
+    static int Index(int cornerPermutation, int nonMiddleSliceEdgePermutation) {
+        return Symmetry::CornerPermutationClass(cornerPermutation)*Symmetry::NonMiddleSliceEdgePermutations
+        + Symmetry::ConjugateNonMiddleSliceEdgePermutation(nonMiddleSliceEdgePermutation,
+                                                           Symmetry::CornerPermutationSymmetry(cornerPermutation));
+    }
+    
+protected:
+    long SearchForward(int begin, int end, unsigned int depth,
+                       const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    long SearchBackward(int begin, int end, unsigned int depth,
+                        const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    
+private:
+    MoveTable& CornerPermutationMoveTable;
+    MoveTable& NonMiddleSliceEdgePermutationMoveTable;
+};
+
+#endif /* Phase2PruningTable_hpp */
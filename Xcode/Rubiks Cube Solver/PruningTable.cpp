@@ -8,17 +8,29 @@
 
 #include "PruningTable.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <iomanip>
+#include <vector>
+
+#include "ThreadPool.hpp"
 
 using namespace std;
 
 PruningTable::PruningTable(MoveTable& moveTable1, MoveTable& moveTable2, int homeOrdinal1, int homeOrdinal2)
-: MoveTable1(moveTable1), MoveTable2(moveTable2), HomeOrdinal1(homeOrdinal1), HomeOrdinal2(homeOrdinal2) {
+: MoveTable1(&moveTable1), MoveTable2(&moveTable2) {
     // Initialize table sizes
-    MoveTable1Size = MoveTable1.SizeOf();
-    MoveTable2Size = MoveTable2.SizeOf();
+    MoveTable1Size = MoveTable1->SizeOf();
+    MoveTable2Size = MoveTable2->SizeOf();
     TableSize = MoveTable1Size*MoveTable2Size;
+    HomeIndex = MoveTableIndicesToPruningTableIndex(homeOrdinal1, homeOrdinal2);
+    TableEncoding = Nybble;
+    EntriesPerByteShift = 1;
+    BitsPerEntry = 4;
+    EntryMask = Empty;
     
     // Allocate the table
     //   round up to an int and determine
@@ -28,82 +40,195 @@ PruningTable::PruningTable(MoveTable& moveTable1, MoveTable& moveTable2, int hom
     // to deallocation problems when TwstChce.ptb is
     // regenerated -- why?
     // AllocationSize = TableSize/2;
-    Table = new unsigned char[AllocationSize];
+    Table = Storage = 0;
 }
 
-void PruningTable::Initialize(char* fileName) {
-    ifstream infile(fileName, ios::in|ios::binary);
-    if (!infile) {	// If the pruning table file is absent...
-        // Generate the table and save it to a file
-        cout << "Generating" << endl;
+PruningTable::PruningTable(int tableSize, int homeIndex, Encoding encoding)
+: MoveTable1(0), MoveTable2(0), MoveTable1Size(0), MoveTable2Size(0),
+HomeIndex(homeIndex), TableSize(tableSize), TableEncoding(encoding) {
+    if (encoding == DistanceMod3) {
+        EntriesPerByteShift = 2;
+        BitsPerEntry = 2;
+        EntryMask = 0x03;
+    } else {
+        EntriesPerByteShift = 1;
+        BitsPerEntry = 4;
+        EntryMask = Empty;
+    }
+    // Round up to an int, as above
+    AllocationSize = ((TableSize+(32/BitsPerEntry)-1)/(32/BitsPerEntry))*4;
+    Table = Storage = 0;
+}
+
+bool PruningTable::Initialize(const void* image) {
+    if (!image) {
+        // There is no saved pruning table...
+        // Generate the table (the caller saves it)
         Generate();
-        cout << "Saving" << endl;
-        Save(fileName);
-        cout << "Done Saving" << endl;
-    } else {		// The pruning table files exists
-        // Load the existing file
-        cout << "Loading" << endl;
-        Load(infile);
+        return false;
     }
+    // Index straight into the saved image
+    Table = (const unsigned char*)image;
+    return true;
 }
 
 PruningTable::~PruningTable() {
     // Deallocate table storage
-    delete [] Table;
+    delete [] Storage;
 }
 
 // Performs a breadth first search to fill the pruning table
 void PruningTable::Generate() {
     unsigned int depth = 0; // Current search depth
-    int numberOfNodes;		// Number of nodes generated
-    int ordinal1, ordinal2; // Table coordinates
-    int index, index2;		// Table indices
-    int move;
-    int power;
+    long numberOfNodes;		// Number of nodes generated
+    int index;			// Table index
+    
+    // Allocate the table
+    if (!Storage)
+        Storage = new unsigned char[AllocationSize];
+    Table = Storage;
     
-    // Initialize all tables entries to "empty"
-    for (index = 0; index < TableSize; index++)
-        SetValue(index, Empty);
+    // Initialize all tables entries (and the padding) to "empty"
+    memset(Storage, 0xff, AllocationSize);
     
-    // Get root coordinates of search tree
-    //   and initialize to zero
-    SetValue(MoveTableIndicesToPruningTableIndex(HomeOrdinal1, HomeOrdinal2),
-             depth);
+    // The entries at the current depth (the frontier) and at the
+    //   next depth are tracked in bitmaps, so that neither search
+    //   direction has to decode every table entry
+    vector<uint64_t> frontier((TableSize+63)/64), next(frontier.size());
+    
+    // Get root of search tree and initialize to zero
+    index = HomeIndex;
+    SetValue(index, EntryForDistance(depth));
+    frontier[index/64] |= (uint64_t)1<<(index%64);
     numberOfNodes = 1;	// Count root node here
     
-    // While empty table entries exist...
-    while (numberOfNodes < TableSize) {
-        // Scan all entries looking for entries
-        //   corresponding to the current depth
-        for (index = 0; index < TableSize; index++) {
-            // Expand the nodes at the current depth only
-            if (GetValue(index) == depth) {
-                // Apply each possible move
-                for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
-                    PruningTableIndexToMoveTableIndices(index, ordinal1, ordinal2);
-                    // Apply each of the three quarter turns
-                    for (power = 1; power < 4; power++) {
-                        // Use the move mapping table to find the child node
-                        ordinal1 = MoveTable1[ordinal1][move];
-                        ordinal2 = MoveTable2[ordinal2][move];
-                        index2 = MoveTableIndicesToPruningTableIndex(
-                                                                     ordinal1, ordinal2);
-                        
-                        // Update previously unexplored nodes only
-                        if (GetValue(index2) == Empty) {
-                            SetValue(index2, depth+1);
-                            numberOfNodes++;
-                        }
-                        // An optimization that could be done, but is probably not worthwhile
-                        //						if (phase2 && move != Cube::Move::U && move != Cube::Move::D && power == 1)
-                        //							break;
+    // Each depth is split into ranges of entries that are
+    //   searched in parallel.  An entry is only ever changed from
+    //   empty to depth+1, so the result does not depend on which
+    //   thread gets there first, or on how many threads there are.
+    //   Ranges are a whole number of bitmap words (and so of
+    //   table bytes), so each range owns its own entries.
+    ThreadPool pool;
+    int numberOfRanges = pool.Size()*RangesPerThread;
+    int rangeSize = (TableSize+numberOfRanges-1)/numberOfRanges;
+    if (rangeSize < MinimumRangeSize)
+        rangeSize = MinimumRangeSize;
+    rangeSize = (rangeSize+63)/64*64;
+    
+    // While empty table entries exist...  Entries further away
+    //   than the largest value a nybble holds are left empty, which
+    //   reads as Empty: still a lower bound on their distance.
+    while (numberOfNodes < TableSize && (TableEncoding == DistanceMod3 || depth+1 < Empty)) {
+        // Once most of the table is filled there are far fewer empty
+        //   entries than frontier entries, so it is cheaper to look
+        //   for empty entries with a neighbour in the frontier than
+        //   to expand the frontier
+        bool backward = numberOfNodes > TableSize/2;
+        vector<future<long> > ranges;
+        for (index = 0; index < TableSize; index += rangeSize) {
+            int begin = index;
+            int end = min(index+rangeSize, TableSize);
+            ranges.push_back(pool.Submit([this, begin, end, depth, backward, &frontier, &next]() {
+                return backward ? SearchBackward(begin, end, depth, frontier, next)
+                                : SearchForward(begin, end, depth, frontier, next);
+            }));
+        }
+        for (size_t range = 0; range < ranges.size(); range++)
+            numberOfNodes += ranges[range].get();
+        frontier.swap(next);
+        fill(next.begin(), next.end(), 0);
+        depth++;
+    }
+}
+
+// Expand the frontier entries within [begin, end), returning
+//   the number of new nodes found
+long PruningTable::SearchForward(int begin, int end, unsigned int depth,
+                                 const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int ordinal1, ordinal2;	// Table coordinates
+    int index, index2;		// Table indices
+    int word;
+    uint64_t bits;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView moves1 = MoveTable1->View();
+    MoveTableView moves2 = MoveTable2->View();
+    
+    // Visit each entry corresponding to the current depth
+    for (word = begin/64; word < (end+63)/64; word++) {
+        for (bits = frontier[word]; bits; bits &= bits-1) {
+            index = word*64+__builtin_ctzll(bits);
+            // Apply each possible move
+            for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
+                PruningTableIndexToMoveTableIndices(index, ordinal1, ordinal2);
+                // Apply each of the three quarter turns
+                for (power = 1; power < 4; power++) {
+                    // Use the move mapping table to find the child node
+                    ordinal1 = moves1[ordinal1][move];
+                    ordinal2 = moves2[ordinal2][move];
+                    index2 = MoveTableIndicesToPruningTableIndex(
+                                                                 ordinal1, ordinal2);
+                    
+                    // Update previously unexplored nodes only
+                    //   (the child may belong to another range)
+                    if (SetValueIfEmpty(index2, value)) {
+                        __atomic_fetch_or(&next[index2/64], (uint64_t)1<<(index2%64), __ATOMIC_RELAXED);
+                        numberOfNodes++;
                     }
+                    // An optimization that could be done, but is probably not worthwhile
+                    //						if (phase2 && move != Cube::Move::U && move != Cube::Move::D && power == 1)
+                    //							break;
                 }
             }
         }
-        depth++;
-        cout << "Completed Depth = " << depth << endl;
     }
+    return numberOfNodes;
+}
+
+// Fill the empty entries within [begin, end) that have a
+//   neighbour in the frontier, returning the number of new
+//   nodes found.  Every move's inverse is also a move, so the
+//   neighbours of an entry are exactly the entries that lead
+//   to it.
+long PruningTable::SearchBackward(int begin, int end, unsigned int depth,
+                                  const vector<uint64_t>& frontier, vector<uint64_t>& next) {
+    long numberOfNodes = 0;	// Number of nodes generated
+    int ordinal1, ordinal2;	// Table coordinates
+    int index, index2;		// Table indices
+    bool found;
+    int move;
+    int power;
+    unsigned int value = EntryForDistance(depth+1);
+    MoveTableView moves1 = MoveTable1->View();
+    MoveTableView moves2 = MoveTable2->View();
+    
+    // Scan the empty entries only
+    for (index = begin; index < end; index++) {
+        if (!IsEmpty(index))
+            continue;
+        found = false;
+        // Apply each possible move until a neighbour in the frontier turns up
+        for (move = Cube::Move::R; move <= Cube::Move::B && !found; move++) {
+            PruningTableIndexToMoveTableIndices(index, ordinal1, ordinal2);
+            // Apply each of the three quarter turns
+            for (power = 1; power < 4 && !found; power++) {
+                ordinal1 = moves1[ordinal1][move];
+                ordinal2 = moves2[ordinal2][move];
+                index2 = MoveTableIndicesToPruningTableIndex(
+                                                             ordinal1, ordinal2);
+                found = (frontier[index2/64]>>(index2%64))&1;
+            }
+        }
+        // This range owns the entry, so no other thread will touch it
+        if (found) {
+            SetValue(index, value);
+            next[index/64] |= (uint64_t)1<<(index%64);
+            numberOfNodes++;
+        }
+    }
+    return numberOfNodes;
 }
 
 void PruningTable::PruningTableIndexToMoveTableIndices(int index, int& ordinal1, int& ordinal2) {
@@ -118,35 +243,34 @@ int PruningTable::MoveTableIndicesToPruningTableIndex(int ordinal1, int ordinal2
     return ordinal1*MoveTable2Size+ordinal2;
 }
 
-unsigned int PruningTable::OffsetToEntryMask[2] = {
-    Empty<<0,  Empty<<4
-};
-
-unsigned int PruningTable::OffsetToShiftCount[2] = {
-    0, 4
-};
-
-unsigned int PruningTable::GetValue(int index) {
-    // Retrieve the proper nybble
-    int offset = index%2;
-    return (Table[index/2]&OffsetToEntryMask[offset])>>OffsetToShiftCount[offset];
+unsigned int PruningTable::GetValue(int index) const {
+    // Retrieve the proper entry
+    unsigned int shift = (index&((1<<EntriesPerByteShift)-1))*BitsPerEntry;
+    return (Table[index>>EntriesPerByteShift]>>shift)&EntryMask;
 }
 
 void PruningTable::SetValue(int index, unsigned int value) {
-    // Set the proper nybble
-    int i = index/2;
-    int offset = index%2;
-    Table[i] = (Table[i] & ~OffsetToEntryMask[offset]) |
-    (value<<OffsetToShiftCount[offset]);
-}
-
-void PruningTable::Save(char* fileName) {
-    ofstream outfile(fileName, ios::out|ios::binary);
-    outfile.write((const char *)Table, AllocationSize);
+    // Set the proper entry
+    int i = index>>EntriesPerByteShift;
+    unsigned int shift = (index&((1<<EntriesPerByteShift)-1))*BitsPerEntry;
+    Storage[i] = (Storage[i] & ~(EntryMask<<shift)) | (value<<shift);
 }
 
-void PruningTable::Load(ifstream& infile) {
-    infile.read((char *)Table, AllocationSize);
+bool PruningTable::SetValueIfEmpty(int index, unsigned int value) {
+    // Set the proper entry, unless another thread got there first.
+    //   The other entries of the byte may change underneath us, in
+    //   which case the compare and swap fails and is retried.
+    unsigned char* entry = &Storage[index>>EntriesPerByteShift];
+    unsigned int shift = (index&((1<<EntriesPerByteShift)-1))*BitsPerEntry;
+    unsigned char expected = __atomic_load_n(entry, __ATOMIC_RELAXED);
+    unsigned char desired;
+    do {
+        if (((expected>>shift)&EntryMask) != EntryMask)
+            return false;
+        desired = (expected & ~(EntryMask<<shift)) | (value<<shift);
+    } while (!__atomic_compare_exchange_n(entry, &expected, desired, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
 }
 
 // Output the pruning table in human readable form
@@ -25,8 +25,18 @@
 // IDA*, the search is guaranteed to find an optimal (i.e.
 // least number of moves possible) solution.
 //
+// Entries are normally nybbles holding the distance itself.
+// A table may instead hold only the distance modulo 3, in two
+// bits per entry.  Neighbouring configurations are at most one
+// move apart, so knowing the exact distance of one of them is
+// enough to recover the exact distance of the other from its
+// entry (see NeighbourDistance).  A search that carries the
+// distance down the tree then gets exact distances from a table
+// half the size.
+//
 
-#include <fstream>
+#include <cstdint>
+#include <vector>
 
 #include "MoveTable.hpp"
 
@@ -34,17 +44,28 @@ using namespace std;
 
 class PruningTable {
 public:
+    // How distances are stored in the table entries
+    enum Encoding {
+        Nybble,		// The distance, in 4 bits
+        DistanceMod3	// The distance modulo 3, in 2 bits
+    };
+    
     // Constructor - Must provide a pair of move mapping tables
     //   and the associated ordinal corresponding to the cube's
     //   "home" configuration.  The home ordinals correspond to
     //   the root node of the search.
     PruningTable(MoveTable& moveTable1, MoveTable& moveTable2, int homeOrdinal1, int homeOrdinal2);
     
-    ~PruningTable();
+    virtual ~PruningTable();
     
-    // Initialize the pruning table by either generating it
-    //   or loading it from an existing file
-    void Initialize(char* fileName);
+    // Initialize the pruning table by either using a saved image
+    //   of it (see TableBundle.hpp), if there is one, or
+    //   generating it.  Returns whether the image was used.
+    bool Initialize(const void* image);
+    
+    // The table's contents, to be saved, and their size in bytes
+    const void* Image(void) const { return Table; }
+    size_t ImageSize(void) const { return AllocationSize; }
     
     // Convert a pruning table index to the associated pair
     //   of move mapping table indices
@@ -55,45 +76,86 @@ public:
     int MoveTableIndicesToPruningTableIndex(int ordinal1, int ordinal2);
     
     // Get a pruning table value corresponding to the specified index
-    unsigned int GetValue(int index);
+    unsigned int GetValue(int index) const;
     
     // Set a pruning table value at the specified index
     void SetValue(int index, unsigned int value);
     
+    // Set a pruning table value at the specified index if that
+    //   entry is still empty (safe to call from several threads)
+    bool SetValueIfEmpty(int index, unsigned int value);
+    
+    // Whether an entry has yet to be filled
+    bool IsEmpty(int index) const { return GetValue(index) == EntryMask; }
+    
+    // The table entry holding a distance
+    unsigned int EntryForDistance(int distance) const {
+        return TableEncoding == DistanceMod3 ? distance%3 : distance;
+    }
+    
+    // The exact distance of a neighbour of a configuration that is
+    //   distance moves away, given the neighbour's DistanceMod3 entry
+    static int NeighbourDistance(int distance, unsigned int value) {
+        static const int change[3] = { 0, 1, -1 };
+        return distance + change[(value+3-distance%3)%3];
+    }
+    
     // Obtain the size of the table (number of logical entries)
-    int SizeOf(void) { return TableSize; }
+    int SizeOf(void) const { return TableSize; }
     
     // Dump table contents
     void Dump(void);
     
-private:
-    enum { Empty = 0x0f };	// Empty table entry
+protected:
+    enum {
+        Empty = 0x0f,			// Empty table entry
+        RangesPerThread = 8,		// Work units per generation thread and depth
+        MinimumRangeSize = 1<<16	// Smallest range worth handing to a thread
+    };
     
+    // Constructor for tables whose entries are not simply a
+    //   pair of move mapping table indices.  Such tables must
+    //   override both of the search functions below.
+    PruningTable(int tableSize, int homeIndex, Encoding encoding = Nybble);
+    
+    // Advance the search by one depth within a range of entries,
+    //   either by expanding the frontier or by testing the
+    //   empty entries for a neighbour in the frontier
+    virtual long SearchForward(int begin, int end, unsigned int depth,
+                               const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    virtual long SearchBackward(int begin, int end, unsigned int depth,
+                                const vector<uint64_t>& frontier, vector<uint64_t>& next);
+    
+private:
     // Generate the table using breath first search
     void Generate(void);
-    // Save the table to a file
-    void Save(char* fileName);
-    // Load the table from a file
-    void Load(ifstream& infile);
-    
-    // Copies of important variables
-    MoveTable& MoveTable1;
-    MoveTable& MoveTable2;
-    int HomeOrdinal1;
-    int HomeOrdinal2;
+    
+    // Copies of important variables (the move mapping
+    //   tables are absent for derived tables)
+    MoveTable* MoveTable1;
+    MoveTable* MoveTable2;
     int MoveTable1Size;
     int MoveTable2Size;
     
+protected:
+    // Index of the cube's "home" configuration
+    int HomeIndex;
+    
+private:
     // Number of entries in the pruning table
     int TableSize;
+    // Entry layout: log2 of the number of entries per byte,
+    //   the bits per entry and the mask (also the empty value)
+    Encoding TableEncoding;
+    int EntriesPerByteShift;
+    unsigned int BitsPerEntry;
+    unsigned int EntryMask;
     // Actual size, in bytes, allocated for the table
     int AllocationSize;
-    // The table pointer
-    unsigned char (*Table);
-    
-    // Tables for dealing with nybble packing/unpacking
-    static unsigned int OffsetToEntryMask[2];
-    static unsigned int OffsetToShiftCount[2];
+    // The table pointer (into either Storage or a saved image)
+    const unsigned char* Table;
+    // Heap storage for a generated table
+    unsigned char* Storage;
 };
 
 #endif /* PruningTable_hpp */
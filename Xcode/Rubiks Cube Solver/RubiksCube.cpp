@@ -10,6 +10,9 @@
 
 #include "Combinatorics.hpp"
 
+#include <cstdint>
+#include <cstring>		// For memcpy()
+
 // Default constructor
 RubiksCube::RubiksCube() {
     // Initialize the choice lookup tables (Dik Winter's method)
@@ -21,6 +24,11 @@ RubiksCube::RubiksCube() {
 // Destructor
 RubiksCube::~RubiksCube() {}
 
+// Make a copy of the cube
+Cube* RubiksCube::Clone() const {
+    return new RubiksCube(*this);
+}
+
 // Corner orientations
 //   Twist is represented as a trinary (base 3) number
 int RubiksCube::Twist() {
@@ -133,6 +141,205 @@ void RubiksCube::MiddleSliceEdgePermutation(int ordinal) {
     OrdinalToPermutation(ordinal, &EdgeCubiePermutations[FirstMiddleSliceEdgeCubie], 4, FirstMiddleSliceEdgeCubie);
 }
 
+// Positions of the four edges of a layer, each given by its rank
+//   among the cubicles not taken by the edges before it
+int RubiksCube::EdgeQuadruple(int layer) {
+    int taken[NumberOfEdgeCubies] = { 0 };
+    int ordinal = 0;
+    int cubicle;
+    
+    for (int i = 0; i < 4; i++) {
+        int rank = 0;
+        for (cubicle = FirstEdgeCubie; EdgeCubiePermutations[cubicle] != 4*layer+i; cubicle++)
+            if (!taken[cubicle]) rank++;
+        taken[cubicle] = 1;
+        ordinal = ordinal*(NumberOfEdgeCubies-i) + rank;
+    }
+    return ordinal;
+}
+
+void RubiksCube::EdgeQuadruple(int layer, int ordinal) {
+    int rank[4];
+    int cubicle;
+    int edge;		// The current edge
+    
+    for (int i = 3; i >= 0; i--) {
+        rank[i] = ordinal%(NumberOfEdgeCubies-i);
+        ordinal /= NumberOfEdgeCubies-i;
+    }
+    for (cubicle = FirstEdgeCubie; cubicle <= LastEdgeCubie; cubicle++)
+        EdgeCubiePermutations[cubicle] = InvalidCubie;
+    
+    // Place the layer's edges in the free cubicles of the given ranks...
+    for (int i = 0; i < 4; i++) {
+        for (cubicle = FirstEdgeCubie; ; cubicle++)
+            if (EdgeCubiePermutations[cubicle] == InvalidCubie && rank[i]-- == 0) break;
+        EdgeCubiePermutations[cubicle] = 4*layer+i;
+    }
+    // ...and the rest wherever there is room
+    edge = FirstEdgeCubie;
+    for (cubicle = FirstEdgeCubie; cubicle <= LastEdgeCubie; cubicle++) {
+        if (EdgeCubiePermutations[cubicle] != InvalidCubie) continue;
+        if (edge/4 == layer) edge += 4;
+        EdgeCubiePermutations[cubicle] = edge++;
+    }
+}
+
+// Within the phase 2 group the upper and lower edges stay out of
+//   the middle slice, so each of their quadruples is one of only
+//   8*7*6*5 = 1680.  The upper edges' quadruple fixes which cubicles
+//   the lower edges occupy, leaving only their order among them.
+struct RubiksCube::QuadrupleMaps {
+    enum {
+        NonMiddleSliceQuadruples = 8*7*6*5,
+        Orders = 4*3*2*1
+    };
+    
+    QuadrupleMaps() {
+        RubiksCube cube;
+        int ordinal;
+        
+        for (ordinal = 0; ordinal < EdgeQuadruples; ordinal++) {
+            nonMiddleSliceQuadruple[ordinal] = 0;
+            order[ordinal] = 0;
+            middleSliceEdgePermutation[ordinal] = 0;
+        }
+        for (ordinal = 0; ordinal < NonMiddleSliceEdgePermutations; ordinal++) {
+            cube.NonMiddleSliceEdgePermutation(ordinal);
+            int upperEdges = cube.EdgeQuadruple(UpperEdges);
+            int lowerEdges = cube.EdgeQuadruple(LowerEdges);
+            nonMiddleSliceQuadruple[upperEdges] = Compact(upperEdges);
+            order[lowerEdges] = Order(cube, LowerEdges);
+            nonMiddleSliceEdgePermutation[Compact(upperEdges)][order[lowerEdges]] = ordinal;
+        }
+        cube.BackToHome();
+        for (ordinal = 0; ordinal < MiddleSliceEdgePermutations; ordinal++) {
+            cube.MiddleSliceEdgePermutation(ordinal);
+            middleSliceEdgePermutation[cube.EdgeQuadruple(MiddleSliceEdges)] = ordinal;
+        }
+    }
+    
+    // The quadruple of edges that are all within the first eight
+    //   cubicles, whose ranks are then below 8, 7, 6 and 5
+    static int Compact(int quadruple) {
+        int rank3 = quadruple%9;
+        int rank2 = quadruple/9%10;
+        int rank1 = quadruple/90%11;
+        int rank0 = quadruple/990;
+        return ((rank0*7 + rank1)*6 + rank2)*5 + rank3;
+    }
+    
+    // The order of a layer's edges among the cubicles they occupy
+    static int Order(RubiksCube& cube, int layer) {
+        int rank[4];
+        int i = 0;
+        for (int cubicle = FirstEdgeCubie; cubicle <= LastEdgeCubie; cubicle++) {
+            if (cube.EdgeCubiePermutations[cubicle]/4 == layer)
+                rank[i++] = cube.EdgeCubiePermutations[cubicle];
+        }
+        return PermutationToOrdinal(rank, 4);
+    }
+    
+    uint16_t nonMiddleSliceQuadruple[EdgeQuadruples];
+    uint8_t order[EdgeQuadruples];
+    uint8_t middleSliceEdgePermutation[EdgeQuadruples];
+    uint16_t nonMiddleSliceEdgePermutation[NonMiddleSliceQuadruples][Orders];
+};
+
+const RubiksCube::QuadrupleMaps& RubiksCube::MapsOfQuadruples(void) {
+    static const QuadrupleMaps maps;	// Initialized on first use (thread safe)
+    return maps;
+}
+
+void RubiksCube::InitializeQuadrupleMaps(void) {
+    (void)MapsOfQuadruples();
+}
+
+int RubiksCube::NonMiddleSliceEdgePermutationOf(int upperEdges, int lowerEdges) {
+    const QuadrupleMaps& maps = MapsOfQuadruples();
+    return maps.nonMiddleSliceEdgePermutation[maps.nonMiddleSliceQuadruple[upperEdges]][maps.order[lowerEdges]];
+}
+
+int RubiksCube::MiddleSliceEdgePermutationOf(int middleSliceEdges) {
+    return MapsOfQuadruples().middleSliceEdgePermutation[middleSliceEdges];
+}
+
+// The effect of each move is found once by applying it to the home cube
+const RubiksCube::MoveEffect& RubiksCube::EffectOfMove(int move) {
+    struct MoveEffects {
+        MoveEffects() {
+            for (int move = FirstMove; move <= LastMove; move++) {
+                RubiksCube cube;
+                cube.ApplyMove(move);
+                memcpy(effect[move].cornerPermutation, cube.CornerCubiePermutations, sizeof(cube.CornerCubiePermutations));
+                memcpy(effect[move].cornerOrientation, cube.CornerCubieOrientations, sizeof(cube.CornerCubieOrientations));
+                memcpy(effect[move].edgePermutation, cube.EdgeCubiePermutations, sizeof(cube.EdgeCubiePermutations));
+                memcpy(effect[move].edgeOrientation, cube.EdgeCubieOrientations, sizeof(cube.EdgeCubieOrientations));
+            }
+        }
+        MoveEffect effect[NumberOfMoves];
+    };
+    static const MoveEffects effects;	// Initialized on first use (thread safe)
+    return effects.effect[move];
+}
+
+int RubiksCube::TwistAfterMove(int twist, int move) {
+    const MoveEffect& effect = EffectOfMove(move);
+    int orientation[NumberOfCornerCubies];
+    int corner;	// The current corner
+    int paritySum = 0;	// For calculating corner parity
+    
+    // Decode the twist (as in Twist(int twist))
+    for (corner = LastCornerCubie-1; corner >= FirstCornerCubie; corner--) {
+        paritySum += (orientation[corner] = twist%3);
+        twist /= 3;
+    }
+    orientation[LastCornerCubie] = (3-paritySum%3)%3;
+    
+    // Each cubicle receives the orientation of the corner moved
+    //   into it, plus the twist picked up by the move
+    for (corner = FirstCornerCubie; corner < LastCornerCubie; corner++)
+        twist = twist*3 + (orientation[effect.cornerPermutation[corner]] + effect.cornerOrientation[corner])%3;
+    return twist;
+}
+
+int RubiksCube::FlipAfterMove(int flip, int move) {
+    const MoveEffect& effect = EffectOfMove(move);
+    int orientation[NumberOfEdgeCubies];
+    int edge;	// The current edge
+    int paritySum = 0;	// For calculating edge parity
+    
+    // Decode the flip (as in Flip(int flip))
+    for (edge = LastEdgeCubie-1; edge >= FirstEdgeCubie; edge--) {
+        paritySum += (orientation[edge] = flip%2);
+        flip /= 2;
+    }
+    orientation[LastEdgeCubie] = paritySum%2;
+    
+    // Each cubicle receives the orientation of the edge moved
+    //   into it, flipped if the move flips it
+    for (edge = FirstEdgeCubie; edge < LastEdgeCubie; edge++)
+        flip = flip*2 + (orientation[effect.edgePermutation[edge]] ^ effect.edgeOrientation[edge]);
+    return flip;
+}
+
+int RubiksCube::ChoiceAfterMove(int choice, int move) {
+    const MoveEffect& effect = EffectOfMove(move);
+    int permutation[NumberOfEdgeCubies];	// Middle slice edges (others invalid)
+    int choicePermutation[4];
+    int edge;	// The current edge
+    int i = 0;
+    
+    // A cubicle holds a middle slice edge after the move if the
+    //   cubicle it came from held one before
+    ChoicePermutation(choice, permutation);
+    for (edge = FirstEdgeCubie; edge <= LastEdgeCubie; edge++) {
+        if (IsMiddleSliceEdgeCubie(permutation[effect.edgePermutation[edge]]))
+            choicePermutation[i++] = edge;
+    }
+    return ChoiceOrdinal(choicePermutation);
+}
+
 // Predicate to determine if a cubie is a middle slice edge cubie
 int RubiksCube::IsMiddleSliceEdgeCubie(int cubie) {
     return cubie >= FirstMiddleSliceEdgeCubie && cubie <= LastMiddleSliceEdgeCubie;
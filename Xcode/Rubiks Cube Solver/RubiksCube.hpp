@@ -25,12 +25,23 @@ public:
         Choices = 495, // 12 choose 4 = 495
         CornerPermutations = (8*7*6*5*4*3*2*1), // 8! = 40320
         NonMiddleSliceEdgePermutations = (8*7*6*5*4*3*2*1), // 8! = 40320
-        MiddleSliceEdgePermutations = (4*3*2*1) // 4! = 24
+        MiddleSliceEdgePermutations = (4*3*2*1), // 4! = 24
+        EdgeQuadruples = (12*11*10*9) // 12!/8! = 11880
+    };
+    
+    // The three layers of four edges tracked by EdgeQuadruple
+    enum EdgeLayer {
+        UpperEdges = 0,		// UF, UL, UB, UR
+        LowerEdges = 1,		// DF, DL, DB, DR
+        MiddleSliceEdges = 2	// RF, FL, LB, BR
     };
     
     RubiksCube();
     ~RubiksCube();
     
+    // Make a copy of the cube
+    Cube* Clone() const;
+    
     // Phase 1 triple
     
     // Corner orientations (3^7 = 2187)
@@ -55,6 +66,33 @@ public:
     int MiddleSliceEdgePermutation();
     void MiddleSliceEdgePermutation(int ordinal);
     
+    // Full group coordinates, which phase 1 carries along so that
+    //   the phase 2 triple is at hand as soon as phase 1 is solved
+    //   (the corner permutation is the third)
+    
+    // Positions of the four edges of a layer, in order (12!/8! = 11880).
+    //   Every layer moves the same way, so one move mapping table
+    //   serves all three.
+    int EdgeQuadruple(int layer);
+    // Note: Sets the positions of the given layer's edges, and places
+    //   the other edges in the remaining cubicles in ascending order
+    void EdgeQuadruple(int layer, int ordinal);
+    
+    // The phase 2 edge coordinates of a cube in the phase 2 group,
+    //   from the edge quadruples of its layers
+    static int NonMiddleSliceEdgePermutationOf(int upperEdges, int lowerEdges);
+    static int MiddleSliceEdgePermutationOf(int middleSliceEdges);
+    // Build the lookup tables used by the above now, rather than on
+    //   first use
+    static void InitializeQuadrupleMaps(void);
+    
+    // Phase 1 coordinate transitions computed directly from the
+    //   ordinal, without setting up any cubies (these are used
+    //   to generate the phase 1 move mapping tables)
+    static int TwistAfterMove(int twist, int move);
+    static int FlipAfterMove(int flip, int move);
+    static int ChoiceAfterMove(int choice, int move);
+    
 private:
     enum {
         // A 12 bit number, 1 bit for each edge
@@ -66,6 +104,22 @@ private:
     // Predicate to determine if a cubie is a middle slice edge cubie
     static int IsMiddleSliceEdgeCubie(int cubie);
     
+    // The effect of a move on the home cube: the cubie that ends
+    //   up in each cubicle and the twist or flip it picks up on
+    //   the way.  Applying the move to any other cube has the same
+    //   effect on whatever cubies occupy those cubicles.
+    struct MoveEffect {
+        int cornerPermutation[NumberOfCornerCubies];
+        int cornerOrientation[NumberOfCornerCubies];
+        int edgePermutation[NumberOfEdgeCubies];
+        int edgeOrientation[NumberOfEdgeCubies];
+    };
+    static const MoveEffect& EffectOfMove(int move);
+    
+    // Lookup tables mapping edge quadruples to phase 2 coordinates
+    struct QuadrupleMaps;
+    static const QuadrupleMaps& MapsOfQuadruples(void);
+    
 #ifdef KOCIEMBA
     // Compute the choice ordinal from the choice permutation
     static int ChoiceOrdinal(int* choicePermutation);
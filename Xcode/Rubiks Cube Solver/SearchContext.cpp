@@ -0,0 +1,99 @@
+//
+//  SearchContext.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "SearchContext.hpp"
+
+#include "Solver.hpp"
+
+using namespace std;
+
+void SharedSearchState::Reset(void) {
+    minSolutionLength = Huge;	// Any solution disovered will look better than this one!
+    stopped = 0;
+    totalNodes = 0;
+    bestSolutionLength1 = 0;
+    bestSolutionSeconds = 0;
+    start = chrono::steady_clock::now();
+}
+
+void SharedSearchState::SetLimits(const SolveOptions &options) {
+    nodeLimit = options.maxNodes;
+    targetLength = options.targetLength;
+    cancel = options.cancel;
+    onImprovement = options.onImprovement;
+
+    // Whichever of the time limit and the deadline comes first
+    hasDeadline = options.deadline != chrono::steady_clock::time_point();
+    deadline = options.deadline;
+    if (options.timeLimit > 0) {
+        chrono::steady_clock::time_point limit = chrono::steady_clock::now() +
+            chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(options.timeLimit));
+        if (!hasDeadline || limit < deadline)
+            deadline = limit;
+        hasDeadline = true;
+    }
+}
+
+void SharedSearchState::CheckLimits(long nodes) {
+    long total = (totalNodes += nodes);
+
+    if (cancel && cancel->load(memory_order_relaxed))
+        Stop(Solver::CANCELLED);
+    else if (nodeLimit && total >= nodeLimit)
+        Stop(Solver::LIMIT_REACHED);
+    else if (hasDeadline && chrono::steady_clock::now() >= deadline)
+        Stop(Solver::LIMIT_REACHED);
+}
+
+void SharedSearchState::Stop(int reason) {
+    // The first reason to stop wins
+    int running = 0;
+    stopped.compare_exchange_strong(running, reason);
+}
+
+double SharedSearchState::Elapsed(void) const {
+    return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+void SharedSearchState::BestSolution(SolveResult &result) const {
+    if (minSolutionLength < Huge) {
+        result.length = minSolutionLength;
+        result.phase1Length = bestSolutionLength1;
+        result.moves.assign(bestSolution, bestSolution + result.length);
+        result.solutionSeconds = bestSolutionSeconds;
+    } else {
+        result.length = -1;
+        result.phase1Length = 0;
+        result.moves.clear();
+    }
+}
+
+void SearchContext::Reset(void) {
+    nodes1 = 0;
+    totalNodes = 0;
+    nodesSinceLimitCheck = 0;
+    threshold1 = threshold2 = 0;
+    newThreshold1 = newThreshold2 = Huge;
+    solutionLength1 = solutionLength2 = 0;
+    trackedDepth = -1;
+    iteration1 = 0;
+    stack1.suspended = stack2.suspended = false;
+    sliceEnd = 0;
+    suspending = false;
+    ownShared.Reset();
+    shared = &ownShared;
+}
+
+void SearchContext::FlushNodes(void) {
+    totalNodes += nodesSinceLimitCheck;
+    shared->CheckLimits(nodesSinceLimitCheck);
+    nodesSinceLimitCheck = 0;
+    if (sliceEnd && totalNodes >= sliceEnd)
+        suspending = true;
+}
@@ -0,0 +1,289 @@
+//
+//  SearchContext.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef SearchContext_hpp
+#define SearchContext_hpp
+
+//
+// All of the mutable state of a single two phase IDA* search.
+// A context is cheap to create, so each solve (and each
+// thread) gets its own while the read-only SolverTables are
+// shared between all of them.
+//
+// Several contexts may cooperate on the same cube (see
+// Solver::SolveParallel).  They then share a SharedSearchState
+// holding the best solution, its length, the search limits and
+// the reason the search stopped, so that a better solution found
+// by any thread immediately tightens the cutoffs of all of them.
+//
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "RubiksCube.hpp"
+
+// The outcome of solving one cube (or the best solution so far,
+//   when handed to SolveOptions::onImprovement)
+struct SolveResult {
+    SolveResult(void) : status(0), length(-1), phase1Length(0), nodes(0), phase1Nodes(0),
+        seconds(0), solutionSeconds(0) {}
+
+    int status;			// Solver return code
+    int length;			// Number of moves (-1 if none was found)
+    int phase1Length;		// The first phase1Length moves are phase 1 moves
+    vector<int> moves;		// The solution as Cube::Move values
+    long nodes;			// Nodes expanded by both phases
+    long phase1Nodes;		// Of which phase 1 expanded this many
+    double seconds;		// Time spent solving
+    double solutionSeconds;	// Time at which the solution was found
+};
+
+// Limits placed on a single solve.  Once a limit is reached the
+//   search stops and the best solution found so far is kept.
+struct SolveOptions {
+    SolveOptions(void) : timeLimit(0), maxNodes(0), targetLength(0), cancel(nullptr) {}
+
+    double timeLimit;	// Wall clock seconds allowed (0 = unlimited)
+    chrono::steady_clock::time_point deadline;	// Time to stop by (the clock's epoch = none)
+    long maxNodes;	// Phase 1 plus phase 2 nodes allowed (0 = unlimited)
+    int targetLength;	// Stop at the first solution this short (0 = none)
+    const atomic<bool>* cancel;	// Set by another thread to stop the search (may be null)
+
+    // Called with each better solution as soon as it is found, on
+    //   the thread that found it but never by two threads at once.
+    //   The search waits for it, so it should be quick.
+    function<void(const SolveResult&)> onImprovement;
+};
+
+// The top of the phase 1 search tree is split into subtrees that
+//   are searched by different threads.  A subtree is identified by
+//   the moves leading to it and its phase 1 coordinates.
+struct Phase1Subtree {
+    enum { MaxSplitDepth = 2 };
+
+    int twist, flip, choice;
+    int distance;	// Of the parent node (see Solver::StartSearch1)
+    int state;		// Of the move sequence automaton
+    int moves[MaxSplitDepth];
+    int powers[MaxSplitDepth];
+};
+
+// A phase 1 solution waiting for its phase 2 search (see
+//   Solver::SolvePipelined).  It carries the initial phase 2
+//   coordinates along with the phase 1 moves that lead to them.
+struct Phase2Job {
+    enum { MaxSearchDepth = 32 };
+
+    int cornerPermutation;
+    int nonMiddleSliceEdgePermutation;
+    int middleSliceEdgePermutation;
+    int solutionLength1;
+    int moves[MaxSearchDepth];
+    int powers[MaxSearchDepth];
+};
+
+// The path of one IDA* search, kept explicitly rather than on the
+//   call stack so that the search can be suspended and resumed (see
+//   Solver::Resume).  Entry i describes the node at depth i: the
+//   three coordinates of its phase, the exact distance of its parent
+//   (see Solver::StartSearch1), its move sequence automaton state,
+//   the faces it has yet to move and the power of the current one.
+//   The arrays are kept apart so that the entries the search touches
+//   at each node share as few cache lines as possible.
+struct SearchStack {
+    enum { MaxDepth = Phase2Job::MaxSearchDepth };
+
+    // Where the search is to carry on at the current depth
+    enum Step {
+        Enter,		// Look at a new node
+        Evaluate,	// Estimate its cost (after its node was counted)
+        Expand,		// Decide whether to expand it (cost is known)
+        Leaf,		// Finish the phase 2 search of a phase 1 solution
+        Next,		// Move to its next child
+        Backtrack	// Return to its parent
+    };
+
+    int coordinate0[MaxDepth+1];
+    int coordinate1[MaxDepth+1];
+    int coordinate2[MaxDepth+1];
+    int distance[MaxDepth+1];
+    int state[MaxDepth+1];
+    unsigned int faces[MaxDepth+1];
+    int power[MaxDepth+1];
+
+    int root;		// Depth the search began at
+    int depth;		// Depth it stopped at
+    int step;		// And what it was about to do there
+    bool suspended;	// Whether it stopped part way
+};
+
+template<class Item> class BoundedQueue;
+
+class SharedSearchState {
+public:
+    enum {
+        MaxSearchDepth = Phase2Job::MaxSearchDepth,	// Capacity of the move lists
+        Huge = 10000		// An absurdly large number
+    };
+
+    SharedSearchState(void) : nodeLimit(0), hasDeadline(false), targetLength(0), cancel(nullptr) { Reset(); }
+
+    // Forget the best solution and the reason for stopping (but not the limits)
+    void Reset(void);
+
+    // Apply the limits of a solve, measured from now
+    void SetLimits(const SolveOptions &options);
+
+    // Account for nodes expanded by one of the contexts and stop
+    //   the search if a limit has been reached
+    void CheckLimits(long nodes);
+
+    // Stop the search for the given reason, unless it has already stopped
+    void Stop(int reason);
+
+    // Seconds since the search began
+    double Elapsed(void) const;
+
+    // Copy the best solution into a result (the lock must be held)
+    void BestSolution(SolveResult &result) const;
+
+    // Minimum solution length found so far
+    atomic<int> minSolutionLength;
+    // The Solver return code that ended the search (0 while running)
+    atomic<int> stopped;
+    // Nodes expanded by all contexts (updated periodically)
+    atomic<long> totalNodes;
+
+    // The best solution found so far (minSolutionLength moves
+    //   of which the first bestSolutionLength1 are phase 1 moves)
+    mutex lock;				// Guards the best solution
+    int bestSolution[2*MaxSearchDepth];
+    int bestSolutionLength1;
+    double bestSolutionSeconds;
+
+    // When the search began
+    chrono::steady_clock::time_point start;
+
+    // Search limits
+    long nodeLimit;				// 0 when unlimited
+    bool hasDeadline;
+    chrono::steady_clock::time_point deadline;
+    int targetLength;				// 0 when there is none
+    const atomic<bool>* cancel;
+    function<void(const SolveResult&)> onImprovement;
+
+private:
+    SharedSearchState(const SharedSearchState&);
+    SharedSearchState& operator=(const SharedSearchState&);
+};
+
+class SearchContext {
+public:
+    enum {
+        MaxSearchDepth = SharedSearchState::MaxSearchDepth,	// Capacity of the move lists
+        Huge = SharedSearchState::Huge,		// An absurdly large number
+        NodesPerLimitCheck = 1024	// How often the limits are looked at
+    };
+
+    SearchContext(void) : verbose(0), splitDepth(-1), frontier(nullptr), pipeline(nullptr), sliceNodes(0) { Reset(); }
+
+    // Prepare for a fresh search, using this context's own shared state
+    void Reset(void);
+
+    // Cooperate with other contexts on the same solve
+    void Share(SharedSearchState &state) { shared = &state; }
+
+    // Apply the limits of a solve, measured from now
+    void SetLimits(const SolveOptions &options) { shared->SetLimits(options); }
+
+    // Minimum solution length found so far by any cooperating context
+    int MinSolutionLength(void) const { return shared->minSolutionLength.load(memory_order_relaxed); }
+
+    // Non zero (the Solver return code) once the search must stop
+    int Stopped(void) const { return shared->stopped.load(memory_order_relaxed); }
+
+    // Count a node and determine whether the search must stop, or
+    //   be suspended at the end of its slice.  The limits are only
+    //   looked at every so often as the clock is far more expensive
+    //   than a node expansion.
+    int LimitReached(void) {
+        if (++nodesSinceLimitCheck == NodesPerLimitCheck)
+            FlushNodes();
+        return Stopped() || suspending;
+    }
+
+    // Start a slice of sliceNodes nodes
+    void BeginSlice(void) {
+        suspending = false;
+        sliceEnd = sliceNodes ? totalNodes+sliceNodes : 0;
+    }
+
+    // Hand the nodes counted since the last limit check to the shared state
+    void FlushNodes(void);
+
+    // Search variables for the two phase IDA* search
+    int nodes1;					// Number of phase 1 nodes expanded
+    long totalNodes;				// Nodes expanded by both phases
+    int threshold1, threshold2;                     // Current heuristic threshold (cutoff)
+    int newThreshold1, newThreshold2;		// New threshold as determined by current search pass
+
+    int solutionMoves1[MaxSearchDepth], solutionMoves2[MaxSearchDepth];	// List of applied moves
+    int solutionPowers1[MaxSearchDepth], solutionPowers2[MaxSearchDepth];	// List of powers associated with each move
+    int solutionLength1, solutionLength2;		// Length of each solution
+
+    // Report the progress of phase 1 on cout
+    int verbose;
+
+    // When splitting the phase 1 tree, nodes at splitDepth are
+    //   collected in frontier instead of being searched (-1 = no split)
+    int splitDepth;
+    vector<Phase1Subtree>* frontier;
+
+    // When pipelining, phase 1 solutions are queued here for the
+    //   phase 2 workers instead of being searched right away
+    BoundedQueue<Phase2Job>* pipeline;
+
+    // The best solution, limits and stop reason (normally ownShared)
+    SharedSearchState* shared;
+
+    // A copy of the scrambled cube, whose full group coordinates
+    //   are carried along the phase 1 path to find the initial
+    //   phase 2 coordinates.
+    RubiksCube cube;
+
+    // The full group coordinates along the phase 1 path (see
+    //   Solver::Phase1Solved).  Entry i holds those after the
+    //   first i moves, which were trackedMoves and trackedPowers.
+    int trackedDepth;		// Deepest entry (-1 before the first phase 1 solution)
+    int trackedMoves[MaxSearchDepth], trackedPowers[MaxSearchDepth];
+    int cornerPermutations[MaxSearchDepth+1];
+    int upperEdges[MaxSearchDepth+1], lowerEdges[MaxSearchDepth+1], middleSliceEdges[MaxSearchDepth+1];
+
+    // The paths of the phase 1 and phase 2 searches
+    SearchStack stack1, stack2;
+    int iteration1;		// Phase 1 iterative deepenings so far
+
+    // Nodes Solver::Solve and Solver::Resume search before suspending
+    //   the search (0 = never).  Counted as the limits are, so a slice
+    //   may run over by up to NodesPerLimitCheck nodes.
+    long sliceNodes;
+
+private:
+    SearchContext(const SearchContext&);
+    SearchContext& operator=(const SearchContext&);
+
+    int nodesSinceLimitCheck;
+    long sliceEnd;		// totalNodes at which the slice ends (0 = none)
+    bool suspending;		// The slice has ended
+    SharedSearchState ownShared;
+};
+
+#endif /* SearchContext_hpp */
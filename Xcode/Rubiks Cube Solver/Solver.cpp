@@ -7,36 +7,51 @@
 //
 
 #include "Solver.hpp"
+#include "BoundedQueue.hpp"
+#include "ThreadPool.hpp"
 
+#include <cstdint>
 #include <iostream>
 
 using namespace std;
 
+// The automaton is built from Disallowed, applied to every pair of
+//   last two faces
+struct Solver::MoveAutomaton {
+    MoveAutomaton(void) {
+        int solutionMoves[2];
+        int last2, last1, move;
+        
+        for (last2 = 0; last2 <= NoFace; last2++) {
+            for (last1 = 0; last1 <= NoFace; last1++) {
+                int state = last2*(NoFace+1)+last1;
+                // States with a face moved before no face are never reached
+                int depth = last1 == NoFace ? 0 : last2 == NoFace ? 1 : 2;
+                solutionMoves[0] = depth == 2 ? last2 : last1;
+                solutionMoves[1] = last1;
+                allowed[state] = 0;
+                for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
+                    if (!Disallowed(move, solutionMoves, depth))
+                        allowed[state] |= 1<<move;
+                    next[state][move] = last1*(NoFace+1)+move;
+                }
+            }
+        }
+    }
+    
+    uint8_t allowed[AutomatonStates];	// Faces that may be moved next (bit mask)
+    uint8_t next[AutomatonStates][NoFace];	// State after moving each face
+};
+
+const Solver::MoveAutomaton Solver::automaton;
+
 Solver::Solver(void)
-// Phase 1 move mapping tables
-: twistMoveTable(cube), flipMoveTable(cube), choiceMoveTable(cube),
-// Phase 2 move mapping tables
-cornerPermutationMoveTable(cube), nonMiddleSliceEdgePermutationMoveTable(cube), middleSliceEdgePermutationMoveTable(cube),
-
-// Phase 1 pruning tables
-TwistAndFlipPruningTable(
-                         twistMoveTable, flipMoveTable,
-                         cube.Twist(), cube.Flip()),
-TwistAndChoicePruningTable(
-                           twistMoveTable, choiceMoveTable,
-                           cube.Twist(), cube.Choice()),
-FlipAndChoicePruningTable(
-                          flipMoveTable, choiceMoveTable,
-                          cube.Flip(), cube.Choice()),
-// Phase 2 pruning tables
-CornerAndSlicePruningTable(
-                           cornerPermutationMoveTable, middleSliceEdgePermutationMoveTable,
-                           cube.CornerPermutation(), cube.MiddleSliceEdgePermutation()),
-EdgeAndSlicePruningTable(
-                         nonMiddleSliceEdgePermutationMoveTable, middleSliceEdgePermutationMoveTable,
-                         cube.NonMiddleSliceEdgePermutation(), cube.MiddleSliceEdgePermutation())
 {
-    minSolutionLength = Huge;	// Any solution disovered will look better than this one!
+}
+
+Solver::Solver(SolverTablesHandle tables)
+: tables(tables)
+{
 }
 
 Solver::~Solver()
@@ -45,295 +60,732 @@ Solver::~Solver()
 
 void Solver::InitializeTables(void)
 {
-    // Phase 1 move mapping tables
-    
-    cout << "Initializing TwistMoveTable" << endl;
-    twistMoveTable.Initialize("Twist.mtb");
-    cout << "Size = " << twistMoveTable.SizeOf() << endl;
-    
-    cout << "Initializing FlipMoveTable" << endl;
-    flipMoveTable.Initialize("Flip.mtb");
-    cout << "Size = " << flipMoveTable.SizeOf() << endl;
-    
-    cout << "Initializing ChoiceMoveTable" << endl;
-    choiceMoveTable.Initialize("Choice.mtb");
-    cout << "Size = " << choiceMoveTable.SizeOf() << endl;
-    
-    // Phase 2 move mapping tables
-    
-    cout << "Initializing CornerPermutationMoveTable" << endl;
-    cornerPermutationMoveTable.Initialize("CrnrPerm.mtb");
-    cout << "Size = " << cornerPermutationMoveTable.SizeOf() << endl;
-    
-    cout << "Initializing NonMiddleSliceEdgePermutationMoveTable" << endl;
-    nonMiddleSliceEdgePermutationMoveTable.Initialize("EdgePerm.mtb");
-    cout << "Size = " << nonMiddleSliceEdgePermutationMoveTable.SizeOf() << endl;
-    
-    cout << "Initializing MiddleSliceEdgePermutationMoveTable" << endl;
-    middleSliceEdgePermutationMoveTable.Initialize("SlicPerm.mtb");
-    cout << "Size = " << middleSliceEdgePermutationMoveTable.SizeOf() << endl;
+    // Tables handed to us by the caller are already initialized
+    if (!tables)
+        tables = SolverTables::Create();
+}
+
+int Solver::Solve(RubiksCube& scrambledCube) const
+{
+    SearchContext context;
+    return Solve(scrambledCube, context);
+}
+
+int Solver::Solve(RubiksCube& scrambledCube, SearchContext& context) const
+{
+    context.Reset();
     
-    // Phase 1 pruning tables
+    // Make a copy of the scrambled cube for use later on
+    context.cube = scrambledCube;
     
-    cout << "Initializing TwistAndFlipPruningTable" << endl;
-    TwistAndFlipPruningTable.Initialize("TwstFlip.ptb");
-    cout << "Size = " << TwistAndFlipPruningTable.SizeOf() << endl;
+    context.BeginSlice();
+    return Phase1(context);
+}
+
+int Solver::Resume(SearchContext& context) const
+{
+    context.BeginSlice();
+    return ContinuePhase1(context);
+}
+
+SolveResult Solver::Solve(RubiksCube& scrambledCube, const SolveOptions& options) const
+{
+    SearchContext context;
+    context.SetLimits(options);
+    int status = Solve(scrambledCube, context);
+    return Result(context, status);
+}
+
+int Solver::Phase1(SearchContext& context) const
+{
+    RubiksCube& cube = context.cube;
     
-    cout << "Initializing TwistAndChoicePruningTable" << endl;
-    TwistAndChoicePruningTable.Initialize("TwstChce.ptb");
-    cout << "Size = " << TwistAndChoicePruningTable.SizeOf() << endl;
+    // The tables may still be on their way
+    tables->WaitForPhase1();
     
-    cout << "Initializing FlipAndChoicePruningTable" << endl;
-    FlipAndChoicePruningTable.Initialize("FlipChce.ptb");
-    cout << "Size = " << FlipAndChoicePruningTable.SizeOf() << endl;
+    // Establish initial cost estimate to goal state
+    context.threshold1 = tables->Phase1Cost(cube.Twist(), cube.Flip(), cube.Choice());
     
-    // Phase 2 pruning tables
+    context.nodes1 = 1;		// Count root node here
+    context.solutionLength1 = 0;
+    context.iteration1 = 1;
     
-    // Obviously a CornerAndEdgePruningTable doesn't make sense as it's size
-    //   would be extremely large (i.e. 8!*8!)
+    return ContinuePhase1(context);
+}
+
+int Solver::ContinuePhase1(SearchContext& context) const
+{
+    int result = NOT_FOUND;
+    RubiksCube& cube = context.cube;
     
-    cout << "Initializing CornerAndSlicePruningTable" << endl;
-    CornerAndSlicePruningTable.Initialize("CrnrSlic.ptb");
-    cout << "Size = " << CornerAndSlicePruningTable.SizeOf() << endl;
+    do
+    {
+        // Start the next iteration, unless one was suspended
+        if (!context.stack1.suspended)
+        {
+            if (context.verbose)
+                cout << "threshold(" << context.iteration1
+                << ") = " << context.threshold1 << endl;
+            
+            context.newThreshold1 = Huge;	// Any cost will be less than this
+            StartSearch1(context, 0, cube.Twist(), cube.Flip(), cube.Choice(), -1, InitialState);
+        }
+        
+        // Perform the phase 1 IDA* search
+        result = Search1(context);
+        if (result == SUSPENDED)
+            return result;
+        
+        // Establish a new threshold for a deeper search
+        context.threshold1 = context.newThreshold1;
+        
+        // Count interative deepenings
+        context.iteration1++;
+    } while (result == NOT_FOUND);
     
-    cout << "Initializing EdgeAndSlicePruningTable" << endl;
-    EdgeAndSlicePruningTable.Initialize("EdgeSlic.ptb");
-    cout << "Size = " << EdgeAndSlicePruningTable.SizeOf() << endl;
+    context.FlushNodes();
+    if (context.verbose)
+        cout << "Phase 1 nodes = " << context.nodes1 << endl;
+    return result;
 }
 
-int Solver::Solve(RubiksCube& scrambledCube)
+// What became of one phase 1 subtree searched by SolveParallel
+struct Phase1Outcome {
+    int result;
+    int newThreshold;
+    int nodes1;
+    long totalNodes;
+};
+
+int Solver::SolveParallel(RubiksCube& scrambledCube, SearchContext& context, ThreadPool& pool) const
 {
     int iteration = 1;
     int result = NOT_FOUND;
+    RubiksCube& cube = context.cube;
+    vector<Phase1Subtree> frontier;
+    vector<future<Phase1Outcome> > outcomes;
+    
+    context.Reset();
     
     // Make a copy of the scrambled cube for use later on
     cube = scrambledCube;
     
+    // The tables may still be on their way
+    tables->WaitForPhase1();
+    
     // Establish initial cost estimate to goal state
-    threshold1 = Phase1Cost(cube.Twist(), cube.Flip(), cube.Choice());
+    context.threshold1 = tables->Phase1Cost(cube.Twist(), cube.Flip(), cube.Choice());
     
-    nodes1 = 1;		// Count root node here
-    solutionLength1 = 0;
+    context.nodes1 = 1;		// Count root node here
+    context.solutionLength1 = 0;
     
     do
     {
-        cout << "threshold(" << iteration
-        << ") = " << threshold1 << endl;
+        if (context.verbose)
+            cout << "threshold(" << iteration
+            << ") = " << context.threshold1 << endl;
         
-        newThreshold1 = Huge;	// Any cost will be less than this
+        context.newThreshold1 = Huge;	// Any cost will be less than this
         
-        // Perform the phase 1 recursive IDA* search
-        result = Search1(cube.Twist(), cube.Flip(), cube.Choice(), 0);
+        // Search the top of the tree here, collecting the subtrees
+        //   that are rooted at the split depth
+        frontier.clear();
+        context.splitDepth = SplitDepth;
+        context.frontier = &frontier;
+        StartSearch1(context, 0, cube.Twist(), cube.Flip(), cube.Choice(), -1, InitialState);
+        result = Search1(context);
+        context.splitDepth = -1;
+        context.frontier = nullptr;
+        
+        // Search the subtrees in parallel
+        if (result == NOT_FOUND) {
+            outcomes.clear();
+            for (size_t i = 0; i < frontier.size(); i++) {
+                Phase1Subtree subtree = frontier[i];
+                outcomes.push_back(pool.Submit([this, &context, subtree]() {
+                    SearchContext worker;
+                    worker.Share(*context.shared);
+                    worker.verbose = context.verbose;
+                    worker.cube = context.cube;
+                    worker.threshold1 = context.threshold1;
+                    for (int depth = 0; depth < SplitDepth; depth++) {
+                        worker.solutionMoves1[depth] = subtree.moves[depth];
+                        worker.solutionPowers1[depth] = subtree.powers[depth];
+                    }
+                    
+                    StartSearch1(worker, SplitDepth, subtree.twist, subtree.flip, subtree.choice, subtree.distance, subtree.state);
+                    int result = Search1(worker);
+                    worker.FlushNodes();
+                    
+                    // Every other thread can stop once the optimum is known
+                    if (result == OPTIMUM_FOUND)
+                        worker.shared->Stop(OPTIMUM_FOUND);
+                    
+                    Phase1Outcome outcome;
+                    outcome.result = result;
+                    outcome.newThreshold = worker.newThreshold1;
+                    outcome.nodes1 = worker.nodes1;
+                    outcome.totalNodes = worker.totalNodes;
+                    return outcome;
+                }));
+            }
+            
+            for (size_t i = 0; i < outcomes.size(); i++) {
+                Phase1Outcome outcome = outcomes[i].get();
+                if (outcome.newThreshold < context.newThreshold1)
+                    context.newThreshold1 = outcome.newThreshold;
+                context.nodes1 += outcome.nodes1;
+                context.totalNodes += outcome.totalNodes;
+                if (outcome.result != NOT_FOUND)
+                    result = outcome.result;
+            }
+            if (context.Stopped())
+                result = context.Stopped();
+        }
         
         // Establish a new threshold for a deeper search
-        threshold1 = newThreshold1;
+        context.threshold1 = context.newThreshold1;
         
         // Count interative deepenings
         iteration++;
     } while (result == NOT_FOUND);
     
-    cout << "Phase 1 nodes = " << nodes1 << endl;
+    context.FlushNodes();
+    if (context.verbose)
+        cout << "Phase 1 nodes = " << context.nodes1 << endl;
     return result;
 }
 
-int Solver::Search1(int twist, int flip, int choice, int depth)
+int Solver::SolvePipelined(RubiksCube& scrambledCube, SearchContext& context, ThreadPool& pool) const
 {
-    int cost, totalCost;
-    int move;
-    int power;
-    int twist2, flip2, choice2;
+    BoundedQueue<Phase2Job> queue(PipelineCapacity);
+    atomic<int> producing(1);
+    vector<future<void> > consumers;
     int result;
     
-    // Compute cost estimate to phase 1 goal state
-    cost = Phase1Cost(twist, flip, choice);	// h
+    context.Reset();
     
-    if (cost == 0)	// Phase 1 solution found...
-    {
-        solutionLength1 = depth;	// Save phase 1 solution length
+    // Make a copy of the scrambled cube for use later on
+    context.cube = scrambledCube;
+    
+    // Start the phase 2 workers
+    for (int rank = 0; rank < pool.Size(); rank++) {
+        int numberOfWorkers = pool.Size();
+        consumers.push_back(pool.Submit([this, &context, &queue, &producing, rank, numberOfWorkers]() {
+            SearchContext worker;
+            worker.Share(*context.shared);
+            worker.verbose = context.verbose;
+            ConsumePhase2Jobs(worker, queue, producing, rank, numberOfWorkers);
+            worker.FlushNodes();
+        }));
+    }
+    
+    // Produce phase 1 solutions on this thread
+    context.pipeline = &queue;
+    result = Phase1(context);
+    context.pipeline = nullptr;
+    
+    // Any phase 1 solution still queued may yet improve on the best
+    //   solution, so the workers finish the queue before we return
+    producing = 0;
+    for (size_t i = 0; i < consumers.size(); i++)
+        consumers[i].get();
+    
+    context.totalNodes = context.shared->totalNodes;
+    if (context.Stopped())
+        result = context.Stopped();
+    return result;
+}
+
+void Solver::ConsumePhase2Jobs(SearchContext& context, BoundedQueue<Phase2Job>& queue,
+                               const atomic<int>& producing, int rank, int numberOfWorkers) const
+{
+    Phase2Job job;
+    int idle = 0;
+    // Workers join in one at a time as the queue fills up
+    size_t depthToJoin = rank * queue.Capacity() / (2 * numberOfWorkers);
+    
+    while (!context.Stopped()) {
+        bool draining = !producing;
         
-        // We need an appropriately initialized cube in order
-        //   to begin phase 2.  First, create a new cube that
-        //   is a copy of the initial scrambled cube.  Then we
-        //   apply the phase 1 move sequence to that cube.  The
-        //   phase 2 search can then determine the initial
-        //   phase 2 coordinates (corner, edge, and slice
-        //   permutation) from this cube.
-        //
-        //   Note: No attempt is made to merge moves of the same
-        //   face adjacent to the phase 1 & phase 2 boundary since
-        //   the shorter sequence will quickly be found.
+        if ((draining || queue.Size() > depthToJoin) && queue.TryPop(job)) {
+            // A better solution may have been found while the job was queued
+            if (job.solutionLength1 + tables->Phase2Cost(job.cornerPermutation, job.nonMiddleSliceEdgePermutation,
+                                                         job.middleSliceEdgePermutation) >= context.MinSolutionLength()) {
+                idle = 0;
+                continue;
+            }
+            context.solutionLength1 = job.solutionLength1;
+            for (int i = 0; i < job.solutionLength1; i++) {
+                context.solutionMoves1[i] = job.moves[i];
+                context.solutionPowers1[i] = job.powers[i];
+            }
+            (void)Solve2(context, job.cornerPermutation,
+                         job.nonMiddleSliceEdgePermutation, job.middleSliceEdgePermutation);
+            idle = 0;
+            continue;
+        }
+        if (draining && queue.Size() == 0)
+            break;
         
-        RubiksCube phase2Cube = cube;
-        for (int i = 0; i < solutionLength1; i++)
-        {
-            for (power = 0; power < solutionPowers1[i]; power++)
-                phase2Cube.ApplyMove(solutionMoves1[i]);
+        // Back off while there is nothing for this worker to do so
+        //   the phase 1 thread has the processor to itself
+        if (idle < 16)
+            this_thread::yield();
+        else
+            this_thread::sleep_for(chrono::microseconds(idle < 64 ? 50 : 500));
+        idle++;
+    }
+}
+
+vector<SolveResult> Solver::SolveBatch(vector<RubiksCube>& cubes, const BatchOptions& options) const
+{
+    vector<future<SolveResult> > futures;
+    vector<SolveResult> results;
+    
+    {
+        // All workers share this solver, and therefore its tables
+        ThreadPool pool(options.threads);
+        
+        for (size_t i = 0; i < cubes.size(); i++) {
+            RubiksCube* cube = &cubes[i];
+            futures.push_back(pool.Submit([this, cube, &options]() {
+                // The clock starts when a worker picks the cube up,
+                //   but not before the tables are ready, so that the
+                //   first cubes do not spend their time waiting for them
+                tables->WaitForTables();
+                return Solve(*cube, options.limits);
+            }));
         }
-        // Invoke Phase 2
-        (void)Solve2(phase2Cube);
+        
+        for (size_t i = 0; i < futures.size(); i++)
+            results.push_back(futures[i].get());
     }
+    return results;
+}
+
+void Solver::StartSearch1(SearchContext& context, int depth, int twist, int flip, int choice, int distance, int state) const
+{
+    SearchStack& s = context.stack1;
+    
+    s.coordinate0[depth] = twist;
+    s.coordinate1[depth] = flip;
+    s.coordinate2[depth] = choice;
+    s.distance[depth] = distance;
+    s.state[depth] = state;
+    s.root = s.depth = depth;
+    s.step = SearchStack::Enter;
+    s.suspended = false;
+}
+
+int Solver::Suspend(SearchStack& s, int depth, int step)
+{
+    s.depth = depth;
+    s.step = step;
+    s.suspended = true;
+    return SUSPENDED;
+}
+
+int Solver::Search1(SearchContext& context) const
+{
+    const SolverTables& t = *tables;
+    SearchStack& s = context.stack1;
+    int depth = s.depth;
+    int step = s.step;
+    int cost = 0;
+    int totalCost;
+    int move;
+    int from;
+    int result;
     
-    // See if node should be expanded
-    totalCost = depth + cost;	// g + h
+    s.suspended = false;
     
-    if (totalCost <= threshold1)	// Expand node
+    // A search suspended during the phase 2 search of a phase 1
+    //   solution finishes that first
+    if (step == SearchStack::Leaf)
     {
-        // If this happens, we should have found the
-        //   optimal solution at this point, so we
-        //   can exit indicating such.  Note: the first
-        //   complete solution found in phase1 is optimal
-        //   due to it being an addmissible IDA* search.
-        if (depth >= minSolutionLength-1)
-            return OPTIMUM_FOUND;
-        
-        for (move = Cube::Move::R; move <= Cube::Move::B; move++)
+        if (ContinuePhase2(context) == SUSPENDED)
+            return Suspend(s, depth, SearchStack::Leaf);
+        if (context.Stopped())
+            return context.Stopped();
+        step = SearchStack::Expand;
+    }
+    
+    for (;;)
+    {
+        switch (step)
         {
-            if (Disallowed(move, solutionMoves1, depth)) continue;
+        case SearchStack::Enter:
+            // Leave the subtree below a split point to another thread
+            if (depth == context.splitDepth)
+            {
+                Phase1Subtree subtree;
+                subtree.twist = s.coordinate0[depth];
+                subtree.flip = s.coordinate1[depth];
+                subtree.choice = s.coordinate2[depth];
+                subtree.distance = s.distance[depth];
+                subtree.state = s.state[depth];
+                for (int i = 0; i < depth; i++) {
+                    subtree.moves[i] = context.solutionMoves1[i];
+                    subtree.powers[i] = context.solutionPowers1[i];
+                }
+                context.frontier->push_back(subtree);
+                step = SearchStack::Backtrack;
+                break;
+            }
             
-            twist2  = twist;
-            flip2   = flip;
-            choice2 = choice;
+            if (context.LimitReached())
+            {
+                if (context.Stopped())
+                    return context.Stopped();
+                return Suspend(s, depth, SearchStack::Evaluate);
+            }
+            // Fall through
+            
+        case SearchStack::Evaluate:
+            // Compute cost estimate to phase 1 goal state
+            cost = t.Phase1Cost(s.coordinate0[depth], s.coordinate1[depth], s.coordinate2[depth], s.distance[depth]);	// h
             
-            solutionMoves1[depth] = move;
-            for (power = 1; power < 4; power++)
+            if (cost == 0)	// Phase 1 solution found...
             {
-                solutionPowers1[depth] = power;
-                twist2  = twistMoveTable[twist2][move];
-                flip2   = flipMoveTable[flip2][move];
-                choice2 = choiceMoveTable[choice2][move];
-                nodes1++;
-                // Apply the move
-                if((result = Search1(twist2, flip2, choice2, depth+1)))
+                if ((result = Phase1Solved(context, depth)) == SUSPENDED)
+                    return Suspend(s, depth, SearchStack::Leaf);
+                if (result)
                     return result;
             }
+            // Fall through
+            
+        case SearchStack::Expand:
+            // See if node should be expanded
+            totalCost = depth + cost;	// g + h
+            
+            if (totalCost <= context.threshold1)	// Expand node
+            {
+                // If this happens, we should have found the
+                //   optimal solution at this point, so we
+                //   can exit indicating such.  Note: the first
+                //   complete solution found in phase1 is optimal
+                //   due to it being an addmissible IDA* search.
+                if (depth >= context.MinSolutionLength()-1)
+                    return OPTIMUM_FOUND;
+                
+                // Only the faces that keep the sequence canonical
+                s.faces[depth] = automaton.allowed[s.state[depth]];
+                s.power[depth] = 0;
+                step = SearchStack::Next;
+            }
+            else	// Maintain minimum cost exceeding threshold
+            {
+                if (totalCost < context.newThreshold1)
+                    context.newThreshold1 = totalCost;
+                step = SearchStack::Backtrack;
+            }
+            break;
+            
+        case SearchStack::Next:
+            // Apply the next power of the current face, or the
+            //   first of the next face, giving the next child
+            if (s.power[depth] == 0 || s.power[depth] == 3)
+            {
+                if (!s.faces[depth])
+                {
+                    step = SearchStack::Backtrack;
+                    break;
+                }
+                move = __builtin_ctz(s.faces[depth]);
+                s.faces[depth] &= s.faces[depth]-1;
+                context.solutionMoves1[depth] = move;
+                s.power[depth] = 1;
+                from = depth;
+            }
+            else
+            {
+                move = context.solutionMoves1[depth];
+                s.power[depth]++;
+                from = depth+1;
+            }
+            s.coordinate0[depth+1] = t.TwistMoves()[s.coordinate0[from]][move];
+            s.coordinate1[depth+1] = t.FlipMoves()[s.coordinate1[from]][move];
+            s.coordinate2[depth+1] = t.ChoiceMoves()[s.coordinate2[from]][move];
+            context.solutionPowers1[depth] = s.power[depth];
+            context.nodes1++;
+            s.distance[depth+1] = s.distance[depth];
+            s.state[depth+1] = automaton.next[s.state[depth]][move];
+            depth++;
+            step = SearchStack::Enter;
+            break;
+            
+        case SearchStack::Backtrack:
+            if (depth == s.root)
+                return NOT_FOUND;
+            depth--;
+            step = SearchStack::Next;
+            break;
+        }
+    }
+}
+
+// Start (or queue) phase 2 from the phase 1 solution of the given
+//   length held by the context.  Returns non zero if the search
+//   must stop (or SUSPENDED if phase 2 was suspended).
+int Solver::Phase1Solved(SearchContext& context, int depth) const
+{
+    const SolverTables& t = *tables;
+    int power;
+    int i;
+    
+    // A sequence ending in U, D or a half turn of R, L, F or B
+    //   was already in the phase 2 group before its last move, so
+    //   that shorter sequence has been handed to phase 2 already,
+    //   and its phase 2 search covers this one
+    if (depth > 0)
+    {
+        int move = context.solutionMoves1[depth-1];
+        if (move == Cube::Move::U || move == Cube::Move::D || context.solutionPowers1[depth-1] == 2)
+            return context.Stopped();
+    }
+    
+    context.solutionLength1 = depth;	// Save phase 1 solution length
+    
+    // We need the initial phase 2 coordinates (corner, edge,
+    //   and slice permutation) of the cube reached by the phase 1
+    //   move sequence.  Rather than applying the sequence to a
+    //   copy of the scrambled cube, its full group coordinates
+    //   are carried along the path.  Successive phase 1 solutions
+    //   share most of their moves, so only those that changed since
+    //   the last one are applied.
+    //
+    //   Note: No attempt is made to merge moves of the same
+    //   face adjacent to the phase 1 & phase 2 boundary since
+    //   the shorter sequence will quickly be found.
+    
+    // The full group tables are phase 2 tables
+    t.WaitForPhase2();
+    
+    if (context.trackedDepth < 0)
+    {
+        context.cornerPermutations[0] = context.cube.CornerPermutation();
+        context.upperEdges[0] = context.cube.EdgeQuadruple(RubiksCube::UpperEdges);
+        context.lowerEdges[0] = context.cube.EdgeQuadruple(RubiksCube::LowerEdges);
+        context.middleSliceEdges[0] = context.cube.EdgeQuadruple(RubiksCube::MiddleSliceEdges);
+        context.trackedDepth = 0;
+    }
+    for (i = 0; i < depth && i < context.trackedDepth; i++)
+    {
+        if (context.trackedMoves[i] != context.solutionMoves1[i] ||
+            context.trackedPowers[i] != context.solutionPowers1[i])
+            break;
+    }
+    for (; i < depth; i++)
+    {
+        int move = context.solutionMoves1[i];
+        int cornerPermutation = context.cornerPermutations[i];
+        int upperEdges = context.upperEdges[i];
+        int lowerEdges = context.lowerEdges[i];
+        int middleSliceEdges = context.middleSliceEdges[i];
+        for (power = 0; power < context.solutionPowers1[i]; power++)
+        {
+            cornerPermutation = t.Phase1CornerPermutationMoves()[cornerPermutation][move];
+            upperEdges = t.EdgeQuadrupleMoves()[upperEdges][move];
+            lowerEdges = t.EdgeQuadrupleMoves()[lowerEdges][move];
+            middleSliceEdges = t.EdgeQuadrupleMoves()[middleSliceEdges][move];
+        }
+        context.trackedMoves[i] = move;
+        context.trackedPowers[i] = context.solutionPowers1[i];
+        context.cornerPermutations[i+1] = cornerPermutation;
+        context.upperEdges[i+1] = upperEdges;
+        context.lowerEdges[i+1] = lowerEdges;
+        context.middleSliceEdges[i+1] = middleSliceEdges;
+    }
+    context.trackedDepth = depth;
+    
+    int cornerPermutation = context.cornerPermutations[depth];
+    int nonMiddleSliceEdgePermutation =
+        RubiksCube::NonMiddleSliceEdgePermutationOf(context.upperEdges[depth], context.lowerEdges[depth]);
+    int middleSliceEdgePermutation = RubiksCube::MiddleSliceEdgePermutationOf(context.middleSliceEdges[depth]);
+    
+    // Phase 2 can not improve on the best solution if even its
+    //   estimate takes the total to the best length.  Late in the
+    //   search most phase 1 solutions go no further than this.
+    if (depth + t.Phase2Cost(cornerPermutation, nonMiddleSliceEdgePermutation, middleSliceEdgePermutation)
+        >= context.MinSolutionLength())
+        return context.Stopped();
+    
+    if (context.pipeline)	// Hand phase 2 to the workers...
+    {
+        Phase2Job job;
+        job.cornerPermutation = cornerPermutation;
+        job.nonMiddleSliceEdgePermutation = nonMiddleSliceEdgePermutation;
+        job.middleSliceEdgePermutation = middleSliceEdgePermutation;
+        job.solutionLength1 = depth;
+        for (i = 0; i < depth; i++) {
+            job.moves[i] = context.solutionMoves1[i];
+            job.powers[i] = context.solutionPowers1[i];
         }
+        // ...unless they have fallen too far behind, in which
+        //   case this thread lends a hand
+        if (!context.pipeline->TryPush(job))
+            (void)Solve2(context, job.cornerPermutation,
+                         job.nonMiddleSliceEdgePermutation, job.middleSliceEdgePermutation);
     }
-    else	// Maintain minimum cost exceeding threshold
+    else	// Invoke Phase 2
     {
-        if (totalCost < newThreshold1)
-            newThreshold1 = totalCost;
+        if (Solve2(context, cornerPermutation, nonMiddleSliceEdgePermutation, middleSliceEdgePermutation) == SUSPENDED)
+            return SUSPENDED;
     }
-    return NOT_FOUND;
+    return context.Stopped();
 }
 
-int Solver::Solve2(RubiksCube& cube)
+int Solver::Solve2(SearchContext& context, int cornerPermutation, int nonMiddleSliceEdgePermutation, int middleSliceEdgePermutation) const
 {
-    int iteration = 1;
-    int result = NOT_FOUND;
+    // The phase 2 tables may still be on their way
+    tables->WaitForPhase2();
     
     // Establish initial cost estimate to goal state
-    threshold2 = Phase2Cost(
-                            cube.CornerPermutation(),
-                            cube.NonMiddleSliceEdgePermutation(),
-                            cube.MiddleSliceEdgePermutation());
+    context.threshold2 = tables->Phase2Cost(
+                            cornerPermutation,
+                            nonMiddleSliceEdgePermutation,
+                            middleSliceEdgePermutation);
+    
+    context.solutionLength2 = 0;
     
-    nodes2 = 1;		// Count root node here
-    solutionLength2 = 0;
+    // The root of every iteration
+    context.stack2.coordinate0[0] = cornerPermutation;
+    context.stack2.coordinate1[0] = nonMiddleSliceEdgePermutation;
+    context.stack2.coordinate2[0] = middleSliceEdgePermutation;
+    context.stack2.suspended = false;
+    
+    return ContinuePhase2(context);
+}
+
+int Solver::ContinuePhase2(SearchContext& context) const
+{
+    SearchStack& s = context.stack2;
+    int result = NOT_FOUND;
     
     do
     {
-        newThreshold2 = Huge;	// Any cost will be less than this
+        // Start the next iteration, unless one was suspended
+        if (!s.suspended)
+        {
+            context.newThreshold2 = Huge;	// Any cost will be less than this
+            s.distance[0] = -1;
+            s.state[0] = InitialState;
+            s.root = s.depth = 0;
+            s.step = SearchStack::Enter;
+        }
         
-        // Perform the phase 2 recursive IDA* search
-        result = Search2(
-                         cube.CornerPermutation(),
-                         cube.NonMiddleSliceEdgePermutation(),
-                         cube.MiddleSliceEdgePermutation(), 0);
+        // Perform the phase 2 IDA* search
+        result = Search2(context);
+        if (result == SUSPENDED)
+            return result;
         
         // Establish a new threshold for a deeper search
-        threshold2 = newThreshold2;
-        
-        // Count interative deepenings
-        iteration++;
+        context.threshold2 = context.newThreshold2;
     } while (result == NOT_FOUND);
-    
-    //	cout << "Phase 2 nodes = " << nodes2 << endl;
     return result;
 }
 
-int Solver::Search2(int cornerPermutation, int nonMiddleSliceEdgePermutation, int middleSliceEdgePermutation, int depth) {
-    int cost, totalCost;
+int Solver::Search2(SearchContext& context) const
+{
+    const SolverTables& t = *tables;
+    SearchStack& s = context.stack2;
+    int depth = s.depth;
+    int step = s.step;
+    int cost = 0;
+    int totalCost;
     int move;
-    int power, powerLimit;
-    int	cornerPermutation2;
-    int nonMiddleSliceEdgePermutation2;
-    int middleSliceEdgePermutation2;
-    int result;
-    
-    // Compute cost estimate to goal state
-    cost = Phase2Cost(cornerPermutation, nonMiddleSliceEdgePermutation, middleSliceEdgePermutation);	// h
-    
-    if (cost == 0) {	// Solution found...
-        solutionLength2 = depth;	// Save phase 2 solution length
-        if (solutionLength1 + solutionLength2 < minSolutionLength)
-            minSolutionLength = solutionLength1 + solutionLength2;
-        PrintSolution();
-        return FOUND;
-    }
+    int from;
+    int powerLimit;
     
-    // See if node should be expanded
-    totalCost = depth + cost;	// g + h
+    s.suspended = false;
     
-    if (totalCost <= threshold2) {	// Expand node
-        // No point in continuing to search for solutions of equal or greater
-        //   length than the current best solution
-        if (solutionLength1 + depth >= minSolutionLength-1) return ABORT;
-        
-        for (move = Cube::Move::R; move <= Cube::Move::B; move++) {
-            if (Disallowed(move, solutionMoves2, depth)) continue;
+    for (;;)
+    {
+        switch (step)
+        {
+        case SearchStack::Enter:
+            if (context.LimitReached())
+            {
+                if (context.Stopped())
+                    return context.Stopped();
+                return Suspend(s, depth, SearchStack::Evaluate);
+            }
+            // Fall through
             
-            cornerPermutation2 = cornerPermutation;
-            nonMiddleSliceEdgePermutation2 = nonMiddleSliceEdgePermutation;
-            middleSliceEdgePermutation2 = middleSliceEdgePermutation;
+        case SearchStack::Evaluate:
+            // Compute cost estimate to goal state
+            cost = t.Phase2Cost(s.coordinate0[depth], s.coordinate1[depth], s.coordinate2[depth], s.distance[depth]);	// h
             
-            solutionMoves2[depth] = move;
+            if (cost == 0) {	// Solution found...
+                context.solutionLength2 = depth;	// Save phase 2 solution length
+                RecordSolution(context);
+                return FOUND;
+            }
+            // Fall through
+            
+        case SearchStack::Expand:
+            // See if node should be expanded
+            totalCost = depth + cost;	// g + h
+            
+            if (totalCost <= context.threshold2) {	// Expand node
+                // No point in continuing to search for solutions of equal or greater
+                //   length than the current best solution
+                if (context.solutionLength1 + depth >= context.MinSolutionLength()-1) return ABORT;
+                
+                // Only the faces that keep the sequence canonical
+                s.faces[depth] = automaton.allowed[s.state[depth]];
+                s.power[depth] = 0;
+                step = SearchStack::Next;
+            } else {	// Maintain minimum cost exceeding threshold
+                if (totalCost < context.newThreshold2)
+                    context.newThreshold2 = totalCost;
+                step = SearchStack::Backtrack;
+            }
+            break;
+            
+        case SearchStack::Next:
+            // Phase 2 turns R, L, F and B by half turns only, which
+            //   the move mapping tables give as a single move
+            move = context.solutionMoves2[depth];
             powerLimit = 4;
             if (move != Cube::Move::U && move != Cube::Move::D) powerLimit=2;
             
-            for (power = 1; power < powerLimit; power++) {
-                cornerPermutation2 =
-                cornerPermutationMoveTable[cornerPermutation2][move];
-                nonMiddleSliceEdgePermutation2 =
-                nonMiddleSliceEdgePermutationMoveTable[nonMiddleSliceEdgePermutation2][move];
-                middleSliceEdgePermutation2 =
-                middleSliceEdgePermutationMoveTable[middleSliceEdgePermutation2][move];
-                
-                solutionPowers2[depth] = power;
-                
-                nodes2++;
-                // Apply the move
-                if((result = Search2(cornerPermutation2, nonMiddleSliceEdgePermutation2, middleSliceEdgePermutation2, depth+1)))
-                    return result;
+            if (s.power[depth] == 0 || s.power[depth] == powerLimit-1) {
+                if (!s.faces[depth]) {
+                    step = SearchStack::Backtrack;
+                    break;
+                }
+                move = __builtin_ctz(s.faces[depth]);
+                s.faces[depth] &= s.faces[depth]-1;
+                context.solutionMoves2[depth] = move;
+                s.power[depth] = 1;
+                from = depth;
+            } else {
+                s.power[depth]++;
+                from = depth+1;
             }
+            s.coordinate0[depth+1] = t.CornerPermutationMoves()[s.coordinate0[from]][move];
+            s.coordinate1[depth+1] = t.NonMiddleSliceEdgePermutationMoves()[s.coordinate1[from]][move];
+            s.coordinate2[depth+1] = t.MiddleSliceEdgePermutationMoves()[s.coordinate2[from]][move];
+            context.solutionPowers2[depth] = s.power[depth];
+            s.distance[depth+1] = s.distance[depth];
+            s.state[depth+1] = automaton.next[s.state[depth]][move];
+            depth++;
+            step = SearchStack::Enter;
+            break;
+            
+        case SearchStack::Backtrack:
+            if (depth == s.root)
+                return NOT_FOUND;
+            depth--;
+            step = SearchStack::Next;
+            break;
         }
-    } else {	// Maintain minimum cost exceeding threshold
-        if (totalCost < newThreshold2)
-            newThreshold2 = totalCost;
     }
-    return NOT_FOUND;
-}
-
-int Solver::Phase1Cost(int twist, int flip, int choice) {
-    // Combining admissible heuristics by taking their maximum
-    //   produces an improved admissible heuristic.
-    int cost = TwistAndFlipPruningTable.GetValue(twist*flipMoveTable.SizeOf()+flip);
-    int cost2 = TwistAndChoicePruningTable.GetValue(twist*choiceMoveTable.SizeOf()+choice);
-    if (cost2 > cost) cost = cost2;
-    cost2 = FlipAndChoicePruningTable.GetValue(flip*choiceMoveTable.SizeOf()+choice);
-    if (cost2 > cost) cost = cost2;
-    return cost;
 }
 
-int Solver::Phase2Cost(int cornerPermutation, int nonMiddleSliceEdgePermutation, int middleSliceEdgePermutation) {
-    // Combining admissible heuristics by taking their maximum
-    //   produces an improved admissible heuristic.
-    int cost = CornerAndSlicePruningTable.GetValue(cornerPermutation*middleSliceEdgePermutationMoveTable.SizeOf()+middleSliceEdgePermutation);
-    int cost2 = EdgeAndSlicePruningTable.GetValue(nonMiddleSliceEdgePermutation*middleSliceEdgePermutationMoveTable.SizeOf()+middleSliceEdgePermutation);
-    if (cost2 > cost) cost = cost2;
-    return cost;
-}
-
-int Solver::Disallowed(int move, int *solutionMoves, int depth) {
+int Solver::Disallowed(int move, const int *solutionMoves, int depth) {
     if (depth > 0) {
         // Disallow successive moves of a single face (RR2 is same as R')
         if (solutionMoves[depth-1] == move)
@@ -357,15 +809,6 @@ int Solver::Disallowed(int move, int *solutionMoves, int depth) {
     return 0;	// This move is allowed
 }
 
-void Solver::PrintSolution(void) {
-    for(int i = 0; i < solutionLength1; i++)
-        cout << Cube::NameOfMove(TranslateMove(solutionMoves1[i], solutionPowers1[i], 0)) << " ";
-    cout << ". "; // Separates phase1 and phase2 portion of the solution
-    for(int i = 0; i < solutionLength2; i++)
-        cout << Cube::NameOfMove(TranslateMove(solutionMoves2[i], solutionPowers2[i], 1)) << " ";
-    cout << "(" << solutionLength1 + solutionLength2 << ")" << endl;
-}
-
 int Solver::TranslateMove(int move, int power, int phase2) {
     int translatedMove = move;
     
@@ -382,3 +825,47 @@ int Solver::TranslateMove(int move, int power, int phase2) {
 }
 
 
+
+void Solver::RecordSolution(SearchContext& context) const {
+    SharedSearchState& shared = *context.shared;
+    int length = context.solutionLength1 + context.solutionLength2;
+    
+    // Another thread may have found a better solution in the meantime
+    lock_guard<mutex> guard(shared.lock);
+    if (length >= shared.minSolutionLength)
+        return;
+    
+    int move = 0;
+    for (int i = 0; i < context.solutionLength1; i++)
+        shared.bestSolution[move++] = TranslateMove(context.solutionMoves1[i], context.solutionPowers1[i], 0);
+    for (int i = 0; i < context.solutionLength2; i++)
+        shared.bestSolution[move++] = TranslateMove(context.solutionMoves2[i], context.solutionPowers2[i], 1);
+    shared.bestSolutionLength1 = context.solutionLength1;
+    shared.bestSolutionSeconds = shared.Elapsed();
+    shared.minSolutionLength = length;
+    
+    if (shared.onImprovement) {
+        SolveResult result;
+        result.status = FOUND;
+        shared.BestSolution(result);
+        result.nodes = shared.totalNodes;
+        result.seconds = result.solutionSeconds;
+        shared.onImprovement(result);
+    }
+    
+    // A solution this short is all the caller asked for
+    if (length <= shared.targetLength)
+        shared.Stop(FOUND);
+}
+
+SolveResult Solver::Result(const SearchContext& context, int status) {
+    SharedSearchState& shared = *context.shared;
+    lock_guard<mutex> guard(shared.lock);
+    SolveResult result;
+    result.status = status;
+    shared.BestSolution(result);
+    result.nodes = context.totalNodes;
+    result.phase1Nodes = context.nodes1;
+    result.seconds = shared.Elapsed();
+    return result;
+}
@@ -70,60 +70,158 @@
 // these topics in depth.
 //
 
-#include "KociMoveTables.hpp"
+#include <vector>
+
 #include "RubiksCube.hpp"
-#include "PruningTable.hpp"
+#include "SearchContext.hpp"
+#include "SolverTables.hpp"
+
+class ThreadPool;
+
+// Options for solving many cubes at once
+struct BatchOptions {
+    BatchOptions(void) : threads(0) {}
+
+    int threads;		// Worker threads (0 = one per hardware thread)
+    SolveOptions limits;	// Limits applied to each cube individually
+};
 
 class Solver {
 public:
+    // A solver that builds its own tables on InitializeTables()
     Solver(void);
+    // A solver sharing an existing, initialized set of tables
+    Solver(SolverTablesHandle tables);
     ~Solver();
     
     // Initializes both the move mapping and pruning tables required
-    //   by the search
+    //   by the search (unless they were supplied by the caller).
+    //   The tables are initialized in the background (see
+    //   SolverTables::Create), and the search waits for them.
     void InitializeTables(void);
     
-    // Perform the two phase search
-    int Solve(RubiksCube &scrambledCube);
+    // The tables used by this solver, so they can be shared
+    //   with other solvers
+    SolverTablesHandle Tables(void) const { return tables; }
+    
+    // Perform the two phase search.  The solver itself holds no
+    //   search state, so any number of threads may solve different
+    //   cubes with the same solver concurrently.
+    int Solve(RubiksCube &scrambledCube) const;
+    int Solve(RubiksCube &scrambledCube, SearchContext &context) const;
+    // The same, subject to the given options, returning the best
+    //   solution found along with how it was found.  Nothing is
+    //   printed; better solutions are reported as they are found
+    //   through options.onImprovement instead.  A time limit starts
+    //   at once, so it includes any wait for the tables.
+    SolveResult Solve(RubiksCube &scrambledCube, const SolveOptions &options) const;
+    
+    // Carry on with a search that Solve (with a context) suspended,
+    //   returning SUSPENDED when it is suspended again.  The context
+    //   holds the whole of the search, so it may be resumed on any
+    //   thread, and the search may be left unfinished by simply not
+    //   resuming it.  The search is suspended every context.sliceNodes
+    //   nodes; SolveParallel and SolvePipelined are never suspended.
+    int Resume(SearchContext &context) const;
+    
+    // Solve a batch of cubes on a pool of worker threads that all
+    //   share this solver's tables.  Each cube is subject to its own
+    //   limits so that one hard cube cannot hold back the others.
+    //   A cube's time limit starts once the tables are ready.
+    //   Results are returned in the same order as the cubes.
+    vector<SolveResult> SolveBatch(vector<RubiksCube> &cubes, const BatchOptions &options) const;
+    
+    // Solve a single cube using all of the threads of a pool.  The
+    //   top levels of the phase 1 tree are expanded on the calling
+    //   thread and the subtrees below them are searched by the pool,
+    //   with every thread sharing the best solution length found so
+    //   far.  The calling thread must not be one of the pool's workers.
+    int SolveParallel(RubiksCube &scrambledCube, SearchContext &context, ThreadPool &pool) const;
+    
+    // Solve a single cube with phase 1 and phase 2 running side by
+    //   side.  The calling thread produces phase 1 solutions into a
+    //   bounded queue that the pool's threads drain, running the
+    //   phase 2 searches.  The calling thread must not be one of the
+    //   pool's workers.
+    int SolvePipelined(RubiksCube &scrambledCube, SearchContext &context, ThreadPool &pool) const;
     // Solver return codes
     enum {
         NOT_FOUND,	// A solution was not found
         FOUND,		// A solution was found
         OPTIMUM_FOUND,	// An optimal solution was found
-        ABORT };	// The search was aborted
+        ABORT,		// The search was aborted
 				//   (i.e. phase 2 did not yield an improved solution)
+        LIMIT_REACHED,	// A time or node limit stopped the search
+        CANCELLED,	// The caller cancelled the search
+        SUSPENDED };	// The search reached the end of its slice (see Resume)
     
-    // Output the solution
-    //   Note: you may not need to call this as the best
-    //   solution, found so far, is output during the search
-    void PrintSolution(void);
+    // Package the best solution held by a context
+    static SolveResult Result(const SearchContext &context, int status);
     
 private:
     
-    enum { Huge = 10000 };	// An absurdly large number
+    enum { Huge = SearchContext::Huge };	// An absurdly large number
+    
+    // Enough room for the phase 2 workers to fall well behind phase 1
+    enum { PipelineCapacity = 1024 };
+    
+    // The iterative deepening loop of phase 1, and the same carried
+    //   on from wherever its search was suspended
+    int Phase1(SearchContext &context) const;
+    int ContinuePhase1(SearchContext &context) const;
     
     // Initiatates the second phase of the search
-    int Solve2(RubiksCube &cube);
-    
-    // Phase 1 & 2 recursive IDA* search routines
-    int Search1(int twist, int flip, int choice, int depth);
-    int Search2(
-                int cornerPermutation,
-                int nonMiddleSliceEdgePermutation,
-                int middleSliceEdgePermutation,
-                int depth);
-    
-    // Phase 1 & 2 cost heuristics
-    int Phase1Cost(int twist, int flip, int choice);
-    int Phase2Cost(
-                   int cornerPermutation,
-                   int nonMiddleSliceEdgePermutation,
-                   int middleSliceEdgePermutation);
+    int Solve2(
+               SearchContext &context,
+               int cornerPermutation,
+               int nonMiddleSliceEdgePermutation,
+               int middleSliceEdgePermutation) const;
+    int ContinuePhase2(SearchContext &context) const;
+    
+    // Phase 2 worker of SolvePipelined: drains the queue until
+    //   phase 1 is done.  Worker rank determines how deep the
+    //   queue must be before the worker joins in.
+    void ConsumePhase2Jobs(SearchContext &context, BoundedQueue<Phase2Job> &queue,
+                           const atomic<int> &producing, int rank, int numberOfWorkers) const;
+    
+    // Phase 1 & 2 IDA* search routines.  Rather than recursing, each
+    //   walks the tree with the context's stack for its phase (see
+    //   SearchStack), from wherever it was left, until the iteration
+    //   is over or it is suspended.
+    int Search1(SearchContext &context) const;
+    int Search2(SearchContext &context) const;
+    
+    // Start a phase 1 search at the given node.  distance is the
+    //   exact distance of its parent held by the full tables (see
+    //   SolverTables::Phase1Cost), or -1 at the root.  state is that
+    //   of the move sequence automaton (see below).
+    void StartSearch1(SearchContext &context, int depth, int twist, int flip, int choice, int distance, int state) const;
+    
+    // Leave a search at the given depth and step, to be resumed there
+    static int Suspend(SearchStack &stack, int depth, int step);
+    
+    // Hand a phase 1 solution on to phase 2.  Returns non zero
+    //   (the reason) if the search must stop, or SUSPENDED if
+    //   phase 2 was suspended.
+    int Phase1Solved(SearchContext &context, int depth) const;
     
     // Predicate to determine if a move is redundant (leads to
     //   (a node that is explored elsewhere) and should therefore
     //   be disallowed.
-    inline int Disallowed(int move, int* solutionMoves, int depth);
+    static inline int Disallowed(int move, const int* solutionMoves, int depth);
+    
+    // The searches generate only canonical move sequences, by way of
+    //   an automaton built from Disallowed.  Its states stand for the
+    //   last two faces moved (NoFace before the first moves), and each
+    //   holds the faces that may be moved next as a bit mask, so the
+    //   searches need not look back at the moves made.
+    enum {
+        NoFace = Cube::Move::B+1,
+        AutomatonStates = (NoFace+1)*(NoFace+1),
+        InitialState = NoFace*(NoFace+1)+NoFace
+    };
+    struct MoveAutomaton;
+    static const MoveAutomaton automaton;
     
     // Translates moves from a (face, power) representation to a
     //   single move string representation (e.g. R,3 becomes R').
@@ -135,40 +233,16 @@ private:
     //   determining the correct power for display purposes only.
     //   I hope that's clear.
     //
-    int TranslateMove(int move, int power, int phase2);
-    
-    // Search variables for the two phase IDA* search
-    int nodes1, nodes2;				// Number of nodes expanded
-    int threshold1, threshold2;                     // Current heuristic threshold (cutoff)
-    int newThreshold1, newThreshold2;		// New threshold as determined by current search pass
-    
-    int solutionMoves1[32], solutionMoves2[32];	// List of applied moves
-    int solutionPowers1[32], solutionPowers2[32];	// List of powers associated with each move
-    int solutionLength1, solutionLength2;		// Length of each solution
-    int minSolutionLength;				// Minimum solution length found so far
-    
-    // A cube used for two purposes:
-    //   1- Initially used by the solver for initializing the move mapping tables
-    //   2- Contains a copy of the scrambled cube that is used at the phase 1/phase 2
-    ///     transition to compute the initial phase 2 coordinates.
-    RubiksCube cube;
-    
-    // Phase 1 move mapping tables
-    TwistMoveTable twistMoveTable;
-    FlipMoveTable flipMoveTable;
-    ChoiceMoveTable choiceMoveTable;
-    // Phase 2 move mapping tables
-    CornerPermutationMoveTable cornerPermutationMoveTable;
-    NonMiddleSliceEdgePermutationMoveTable nonMiddleSliceEdgePermutationMoveTable;
-    MiddleSliceEdgePermutationMoveTable middleSliceEdgePermutationMoveTable;
-    
-    // Phase 1 pruning tables
-    PruningTable TwistAndFlipPruningTable;
-    PruningTable TwistAndChoicePruningTable;
-    PruningTable FlipAndChoicePruningTable;
-    // Phase 2 pruning tables
-    PruningTable CornerAndSlicePruningTable;
-    PruningTable EdgeAndSlicePruningTable;
+    static int TranslateMove(int move, int power, int phase2);
+    
+    // Remember the solution just found if it is the best one so far
+    void RecordSolution(SearchContext &context) const;
+    
+    // Depth at which SolveParallel splits the phase 1 tree
+    enum { SplitDepth = Phase1Subtree::MaxSplitDepth };
+    
+    // The shared, read-only move mapping and pruning tables
+    SolverTablesHandle tables;
 };
 
 #endif /* Solver_hpp */
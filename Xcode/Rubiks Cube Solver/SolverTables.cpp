@@ -0,0 +1,313 @@
+//
+//  SolverTables.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "SolverTables.hpp"
+
+#include <chrono>
+
+#include "EmbeddedTables.hpp"
+
+using namespace std;
+
+SolverTables::SolverTables(unsigned int options)
+: loaders(LoaderThreads), bundleOpened(false), generated(false), saveFailed(false), phase1Ready(false), phase2Ready(false),
+// Phase 1 move mapping tables
+twistMoveTable(cube), flipMoveTable(cube), choiceMoveTable(cube),
+// Phase 2 move mapping tables
+cornerPermutationMoveTable(cube), nonMiddleSliceEdgePermutationMoveTable(cube), middleSliceEdgePermutationMoveTable(cube),
+// Full group move mapping tables
+phase1CornerPermutationMoveTable(cube), edgeQuadrupleMoveTable(cube),
+
+// Phase 1 pruning tables
+TwistAndFlipPruningTable(
+                         twistMoveTable, flipMoveTable,
+                         cube.Twist(), cube.Flip()),
+TwistAndChoicePruningTable(
+                           twistMoveTable, choiceMoveTable,
+                           cube.Twist(), cube.Choice()),
+FlipAndChoicePruningTable(
+                          flipMoveTable, choiceMoveTable,
+                          cube.Flip(), cube.Choice()),
+// Phase 2 pruning tables
+CornerAndSlicePruningTable(
+                           cornerPermutationMoveTable, middleSliceEdgePermutationMoveTable,
+                           cube.CornerPermutation(), cube.MiddleSliceEdgePermutation()),
+EdgeAndSlicePruningTable(
+                         nonMiddleSliceEdgePermutationMoveTable, middleSliceEdgePermutationMoveTable,
+                         cube.NonMiddleSliceEdgePermutation(), cube.MiddleSliceEdgePermutation()),
+options(options)
+{
+}
+
+SolverTables::~SolverTables()
+{
+    // The tables may still be initializing, or being saved
+    if (phase1.valid())
+        phase1.wait();
+    if (phase2.valid())
+        phase2.wait();
+    if (saving.valid())
+        saving.wait();
+}
+
+SolverTablesHandle SolverTables::Create(unsigned int options)
+{
+    shared_ptr<SolverTables> tables(new SolverTables(options));
+    tables->Initialize(true);
+    return tables;
+}
+
+const char* SolverTables::BundleFileName = "Solver.tbl";
+
+// Whether a list of tables includes one of the given name
+static bool Includes(const vector<TableBundle::Image>& images, const string& name)
+{
+    for (size_t image = 0; image < images.size(); image++) {
+        if (images[image].name == name)
+            return true;
+    }
+    return false;
+}
+
+template<class Table>
+void SolverTables::InitializeTable(Table& table, const char* title, const char* name, MappedFile::Access access)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // The embedded tables come first, and the bundle file is only
+    //   opened for a table they lack
+    const void* image = embeddedBundle.Find(name, table.SizeOf(), table.ImageSize(), access);
+    if (!image) {
+        lock_guard<mutex> guard(lock);
+        if (!bundleOpened) {
+            bundle.Open(BundleFileName);
+            bundleOpened = true;
+        }
+        image = bundle.Find(name, table.SizeOf(), table.ImageSize(), access);
+    }
+    bool loaded = table.Initialize(image);
+
+    lock_guard<mutex> guard(lock);
+    if (!loaded)
+        generated = true;
+    images.push_back(TableBundle::Image(name, table.SizeOf(), table.Image(), table.ImageSize()));
+    TableTiming timing;
+    timing.name = title;
+    timing.entries = table.SizeOf();
+    timing.generated = !loaded;
+    timing.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    timings.push_back(timing);
+}
+
+void SolverTables::InParallel(const vector<function<void()> >& steps)
+{
+    vector<future<void> > done;
+    for (size_t step = 0; step < steps.size(); step++)
+        done.push_back(loaders.Submit(steps[step]));
+    // Every step must finish before anything is rethrown, as
+    //   they all refer to the tables
+    for (size_t step = 0; step < done.size(); step++)
+        done[step].wait();
+    for (size_t step = 0; step < done.size(); step++)
+        done[step].get();
+}
+
+// Move tables are small and consulted at every node, so they are
+//   faulted in right away.  Pruning table lookups are scattered all
+//   over the table, so reading ahead would only waste page cache.
+static const MappedFile::Access moveAccess = MappedFile::Hot;
+static const MappedFile::Access pruningAccess = MappedFile::Random;
+
+void SolverTables::Initialize(bool background)
+{
+    if (EmbeddedTables::Bundle())
+        embeddedBundle.Open(EmbeddedTables::Bundle(), EmbeddedTables::SizeOf());
+
+    if (background) {
+        phase1 = async(launch::async, [this]() { InitializePhase1(); }).share();
+        phase2 = async(launch::async, [this]() { InitializePhase2(); }).share();
+        // The search need not wait for the bundle to be written
+        saving = async(launch::async, [this]() {
+            phase1.get();
+            phase2.get();
+            SaveGenerated();
+        }).share();
+    } else {
+        InitializePhase1();
+        InitializePhase2();
+        SaveGenerated();
+    }
+}
+
+void SolverTables::WaitForPhase1(void) const
+{
+    // Rethrows anything thrown while initializing
+    if (!phase1Ready.load(memory_order_acquire))
+        phase1.get();
+}
+
+void SolverTables::WaitForPhase2(void) const
+{
+    if (!phase2Ready.load(memory_order_acquire))
+        phase2.get();
+}
+
+const vector<TableTiming>& SolverTables::WaitForTables(void) const
+{
+    WaitForPhase1();
+    WaitForPhase2();
+    return timings;
+}
+
+bool SolverTables::WaitForSave(void) const
+{
+    if (saving.valid())
+        saving.wait();
+    return !saveFailed;
+}
+
+void SolverTables::InitializePhase1(void)
+{
+    // Phase 1 move mapping tables
+    InParallel({
+        [this]() { InitializeTable(twistMoveTable, "TwistMoveTable", "Twist.mtb", moveAccess); },
+        [this]() { InitializeTable(flipMoveTable, "FlipMoveTable", "Flip.mtb", moveAccess); },
+        [this]() { InitializeTable(choiceMoveTable, "ChoiceMoveTable", "Choice.mtb", moveAccess); }
+    });
+
+    // Views of the move mapping tables for the search
+    twistMoves = twistMoveTable.View();
+    flipMoves = flipMoveTable.View();
+    choiceMoves = choiceMoveTable.View();
+
+    // The pruning tables, all of which are built on the move
+    //   mapping tables above
+    vector<function<void()> > steps;
+
+    // The full table is exact, so the pairwise tables would never
+    //   be consulted beside it
+    if (options&FullPhase1Table) {
+        phase1PruningTable.reset(new Phase1PruningTable(twistMoveTable, flipMoveTable, choiceMoveTable));
+        steps.push_back([this]() { InitializeTable(*phase1PruningTable, "Phase1PruningTable", "FlSlTwst.ptb", pruningAccess); });
+    } else {
+        steps.push_back([this]() { InitializeTable(TwistAndFlipPruningTable, "TwistAndFlipPruningTable", "TwstFlip.ptb", pruningAccess); });
+        steps.push_back([this]() { InitializeTable(TwistAndChoicePruningTable, "TwistAndChoicePruningTable", "TwstChce.ptb", pruningAccess); });
+        steps.push_back([this]() { InitializeTable(FlipAndChoicePruningTable, "FlipAndChoicePruningTable", "FlipChce.ptb", pruningAccess); });
+    }
+    InParallel(steps);
+
+    phase1Ready.store(true, memory_order_release);
+}
+
+void SolverTables::InitializePhase2(void)
+{
+    // Phase 2 move mapping tables
+    InParallel({
+        [this]() { InitializeTable(cornerPermutationMoveTable, "CornerPermutationMoveTable", "CrnrPerm.mtb", moveAccess); },
+        [this]() { InitializeTable(nonMiddleSliceEdgePermutationMoveTable, "NonMiddleSliceEdgePermutationMoveTable", "EdgePerm.mtb", moveAccess); },
+        [this]() { InitializeTable(middleSliceEdgePermutationMoveTable, "MiddleSliceEdgePermutationMoveTable", "SlicPerm.mtb", moveAccess); },
+        [this]() { InitializeTable(phase1CornerPermutationMoveTable, "Phase1CornerPermutationMoveTable", "CrnrPrm1.mtb", moveAccess); },
+        [this]() { InitializeTable(edgeQuadrupleMoveTable, "EdgeQuadrupleMoveTable", "EdgeQuad.mtb", moveAccess); },
+        []() { RubiksCube::InitializeQuadrupleMaps(); }
+    });
+
+    // Views of the move mapping tables for the search
+    cornerPermutationMoves = cornerPermutationMoveTable.View();
+    nonMiddleSliceEdgePermutationMoves = nonMiddleSliceEdgePermutationMoveTable.View();
+    middleSliceEdgePermutationMoves = middleSliceEdgePermutationMoveTable.View();
+    phase1CornerPermutationMoves = phase1CornerPermutationMoveTable.View();
+    edgeQuadrupleMoves = edgeQuadrupleMoveTable.View();
+
+    // The pruning tables
+    vector<function<void()> > steps;
+
+    steps.push_back([this]() { InitializeTable(CornerAndSlicePruningTable, "CornerAndSlicePruningTable", "CrnrSlic.ptb", pruningAccess); });
+    steps.push_back([this]() { InitializeTable(EdgeAndSlicePruningTable, "EdgeAndSlicePruningTable", "EdgeSlic.ptb", pruningAccess); });
+
+    // A plain CornerAndEdgePruningTable doesn't make sense as it's size
+    //   would be extremely large (i.e. 8!*8!), but reducing the corners
+    //   by symmetry brings it down to 2768*8!
+
+    if (options&CornerAndEdgeTable) {
+        phase2PruningTable.reset(new Phase2PruningTable(cornerPermutationMoveTable, nonMiddleSliceEdgePermutationMoveTable));
+        steps.push_back([this]() { InitializeTable(*phase2PruningTable, "Phase2PruningTable", "CrnrEdge.ptb", pruningAccess); });
+    }
+    InParallel(steps);
+
+    phase2Ready.store(true, memory_order_release);
+}
+
+void SolverTables::SaveGenerated(void)
+{
+    // Save any tables that had to be generated, along with the
+    //   rest of the bundle (but not the embedded tables)
+    if (generated) {
+        vector<TableBundle::Image> saved;
+        for (size_t image = 0; image < images.size(); image++) {
+            if (!Includes(embeddedBundle.Catalogue(), images[image].name))
+                saved.push_back(images[image]);
+        }
+        const vector<TableBundle::Image>& catalogue = bundle.Catalogue();
+        for (size_t table = 0; table < catalogue.size(); table++) {
+            if (!Includes(saved, catalogue[table].name))
+                saved.push_back(catalogue[table]);
+        }
+        saveFailed = !TableBundle::Save(BundleFileName, saved);
+    }
+}
+
+bool SolverTables::Save(const char* fileName) const
+{
+    return TableBundle::Save(fileName, images);
+}
+
+int SolverTables::Phase1Cost(int twist, int flip, int choice) const {
+    int distance = -1;
+    return Phase1Cost(twist, flip, choice, distance);
+}
+
+int SolverTables::Phase2Cost(int cornerPermutation, int nonMiddleSliceEdgePermutation, int middleSliceEdgePermutation) const {
+    int distance = -1;
+    return Phase2Cost(cornerPermutation, nonMiddleSliceEdgePermutation, middleSliceEdgePermutation, distance);
+}
+
+int SolverTables::Phase1Cost(int twist, int flip, int choice, int& distance) const {
+    // The full table is exact, so there is nothing to combine
+    //   (its FlipSlice coordinate is flip*Choices+choice)
+    if (phase1PruningTable) {
+        int flipSlice = flip*RubiksCube::Choices+choice;
+        distance = distance < 0
+        ? phase1PruningTable->Distance(twist, flipSlice)
+        : phase1PruningTable->Distance(twist, flipSlice, distance);
+        return distance;
+    }
+
+    // Combining admissible heuristics by taking their maximum
+    //   produces an improved admissible heuristic.
+    int cost = TwistAndFlipPruningTable.GetValue(twist*flipMoveTable.SizeOf()+flip);
+    int cost2 = TwistAndChoicePruningTable.GetValue(twist*choiceMoveTable.SizeOf()+choice);
+    if (cost2 > cost) cost = cost2;
+    cost2 = FlipAndChoicePruningTable.GetValue(flip*choiceMoveTable.SizeOf()+choice);
+    if (cost2 > cost) cost = cost2;
+    return cost;
+}
+
+int SolverTables::Phase2Cost(int cornerPermutation, int nonMiddleSliceEdgePermutation, int middleSliceEdgePermutation, int& distance) const {
+    // Combining admissible heuristics by taking their maximum
+    //   produces an improved admissible heuristic.
+    int cost = CornerAndSlicePruningTable.GetValue(cornerPermutation*middleSliceEdgePermutationMoveTable.SizeOf()+middleSliceEdgePermutation);
+    int cost2 = EdgeAndSlicePruningTable.GetValue(nonMiddleSliceEdgePermutation*middleSliceEdgePermutationMoveTable.SizeOf()+middleSliceEdgePermutation);
+    if (cost2 > cost) cost = cost2;
+    if (phase2PruningTable) {
+        distance = distance < 0
+        ? phase2PruningTable->Distance(cornerPermutation, nonMiddleSliceEdgePermutation)
+        : phase2PruningTable->Distance(cornerPermutation, nonMiddleSliceEdgePermutation, distance);
+        if (distance > cost) cost = distance;
+    }
+    return cost;
+}
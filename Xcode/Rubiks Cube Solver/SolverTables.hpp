@@ -0,0 +1,222 @@
+//
+//  SolverTables.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef SolverTables_hpp
+#define SolverTables_hpp
+
+//
+// The move mapping and pruning tables used by the two phase
+// search.  Once initialized, the tables are never modified
+// again, so a single instance can be shared (via a reference
+// counted handle) by any number of solvers running on any
+// number of threads.  All mutable search state lives in a
+// SearchContext instead (see SearchContext.hpp).
+//
+// Optionally, a pruning table over the complete phase 1
+// coordinate may be used, which gives the exact phase 1 distance
+// in place of the three pairwise bounds (see Phase1PruningTable.hpp),
+// and one over the phase 2 corner and edge permutations, which
+// strengthens the phase 2 bound (see Phase2PruningTable.hpp).
+//
+// The tables are all saved to a single bundle file (see
+// TableBundle.hpp).  Any table the bundle lacks is generated, and
+// the bundle is then rewritten with it, keeping the tables that
+// other configurations use as well.  When the tables are initialized
+// in the background, the bundle is written only after they are all
+// ready, and the search does not wait for it.  Tables built into the
+// executable (see EmbeddedTables.hpp) are used in preference, and
+// when they are all that is needed the bundle file is never read.
+//
+// The tables may be initialized in the background, so that the
+// caller can get on with reading its input in the meantime.  The
+// tables of each phase are initialized on a small pool of threads,
+// first the move mapping tables side by side and then the tables
+// built on them.  Phase 1 can not make use of the phase 2 tables
+// until it finds its first solution, so the search need only wait
+// for the phase 1 tables before it gets under way.  Tables that the
+// options make redundant are never initialized at all.
+//
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "KociMoveTables.hpp"
+#include "Phase1PruningTable.hpp"
+#include "Phase2PruningTable.hpp"
+#include "RubiksCube.hpp"
+#include "PruningTable.hpp"
+#include "TableBundle.hpp"
+#include "ThreadPool.hpp"
+
+class SolverTables;
+
+// How one table was initialized
+struct TableTiming {
+    string name;
+    int entries;
+    bool generated;	// Rather than loaded
+    double seconds;
+};
+
+// Reference counted handle to a set of initialized, read-only tables
+typedef shared_ptr<const SolverTables> SolverTablesHandle;
+
+class SolverTables {
+public:
+    // Optional tables, which may be combined
+    enum Options {
+        FullPhase1Table = 1,		// Twist by FlipSlice class phase 1 pruning table
+        CornerAndEdgeTable = 2		// Corner class by edge phase 2 pruning table
+    };
+
+    SolverTables(unsigned int options = 0);
+    ~SolverTables();
+
+    // Construct a shareable set of tables and start initializing
+    //   them in the background
+    static SolverTablesHandle Create(unsigned int options = 0);
+
+    // The bundle the tables are loaded from and saved to
+    static const char* BundleFileName;
+
+    // Initializes both the move mapping and pruning tables required
+    //   by the search, either before returning or in the background
+    void Initialize(bool background = false);
+
+    // Wait until the tables of a phase are ready.  This must be
+    //   called before any of them (or their costs) are used.
+    void WaitForPhase1(void) const;
+    void WaitForPhase2(void) const;
+    // Wait until every table is ready, returning how each one was
+    //   initialized, in the order they were finished
+    const vector<TableTiming>& WaitForTables(void) const;
+    // Wait until any tables that had to be generated have been saved
+    //   to the bundle, returning false if they could not be
+    bool WaitForSave(void) const;
+
+    // Save the initialized tables, and only those, to a bundle
+    bool Save(const char* fileName) const;
+
+    // Phase 1 & 2 cost heuristics
+    int Phase1Cost(int twist, int flip, int choice) const;
+    int Phase2Cost(
+                   int cornerPermutation,
+                   int nonMiddleSliceEdgePermutation,
+                   int middleSliceEdgePermutation) const;
+    
+    // The same, carrying the exact distance held by the full phase 1
+    //   or the phase 2 corner and edge table down the search tree
+    //   (those tables only hold distances modulo 3).  On entry
+    //   distance is that of the parent position, or -1 at the root,
+    //   and on return it is that of this position.
+    int Phase1Cost(int twist, int flip, int choice, int &distance) const;
+    int Phase2Cost(
+                   int cornerPermutation,
+                   int nonMiddleSliceEdgePermutation,
+                   int middleSliceEdgePermutation,
+                   int &distance) const;
+
+    // Whether Phase1Cost is exact
+    bool HasFullPhase1Table(void) const { return phase1PruningTable.get() != 0; }
+
+    // Phase 1 move mapping tables
+    MoveTableView TwistMoves(void) const { return twistMoves; }
+    MoveTableView FlipMoves(void) const { return flipMoves; }
+    MoveTableView ChoiceMoves(void) const { return choiceMoves; }
+    // Phase 2 move mapping tables
+    MoveTableView CornerPermutationMoves(void) const { return cornerPermutationMoves; }
+    MoveTableView NonMiddleSliceEdgePermutationMoves(void) const { return nonMiddleSliceEdgePermutationMoves; }
+    MoveTableView MiddleSliceEdgePermutationMoves(void) const { return middleSliceEdgePermutationMoves; }
+    // Full group move mapping tables, for carrying the phase 2
+    //   coordinates through phase 1 (these are phase 2 tables)
+    MoveTableView Phase1CornerPermutationMoves(void) const { return phase1CornerPermutationMoves; }
+    MoveTableView EdgeQuadrupleMoves(void) const { return edgeQuadrupleMoves; }
+
+private:
+    // The tables own large buffers, copying them makes no sense
+    SolverTables(const SolverTables&);
+    SolverTables& operator=(const SolverTables&);
+
+    // Initialize the tables of either phase
+    void InitializePhase1(void);
+    void InitializePhase2(void);
+    // Rewrite the bundle if any table had to be generated
+    void SaveGenerated(void);
+
+    // Initialize a table from the bundle, recording it for saving
+    //   and noting whether it had to be generated, and its timing
+    template<class Table>
+    void InitializeTable(Table& table, const char* title, const char* name, MappedFile::Access access);
+    // Run initialization steps side by side on the loader pool
+    void InParallel(const vector<function<void()> >& steps);
+
+    enum { LoaderThreads = 4 };	// Tables initialized at once
+
+    // The pool the tables are initialized on
+    ThreadPool loaders;
+
+    // The embedded and saved tables, which the tables below may
+    //   point into (so they must outlive them)
+    TableBundle embeddedBundle;
+    TableBundle bundle;
+    bool bundleOpened;
+    // The tables as initialized, for saving, and their timings
+    vector<TableBundle::Image> images;
+    bool generated;
+    bool saveFailed;
+    vector<TableTiming> timings;
+    // Guards the bundle file and the above
+    mutex lock;
+    // Completion of the tables of each phase, and of their saving
+    shared_future<void> phase1, phase2;
+    atomic<bool> phase1Ready, phase2Ready;
+    shared_future<void> saving;
+
+    // A cube that is manipulated by the move mapping tables
+    //   while they are being generated
+    RubiksCube cube;
+
+    // Phase 1 move mapping tables
+    TwistMoveTable twistMoveTable;
+    FlipMoveTable flipMoveTable;
+    ChoiceMoveTable choiceMoveTable;
+    // Phase 2 move mapping tables
+    CornerPermutationMoveTable cornerPermutationMoveTable;
+    NonMiddleSliceEdgePermutationMoveTable nonMiddleSliceEdgePermutationMoveTable;
+    MiddleSliceEdgePermutationMoveTable middleSliceEdgePermutationMoveTable;
+    // Full group move mapping tables
+    Phase1CornerPermutationMoveTable phase1CornerPermutationMoveTable;
+    EdgeQuadrupleMoveTable edgeQuadrupleMoveTable;
+    
+    // Views of the above for the search
+    MoveTableView twistMoves, flipMoves, choiceMoves;
+    MoveTableView cornerPermutationMoves, nonMiddleSliceEdgePermutationMoves, middleSliceEdgePermutationMoves;
+    MoveTableView phase1CornerPermutationMoves, edgeQuadrupleMoves;
+
+    // Phase 1 pruning tables
+    PruningTable TwistAndFlipPruningTable;
+    PruningTable TwistAndChoicePruningTable;
+    PruningTable FlipAndChoicePruningTable;
+    // Phase 2 pruning tables
+    PruningTable CornerAndSlicePruningTable;
+    PruningTable EdgeAndSlicePruningTable;
+
+    // Optional tables, as selected by options
+    unsigned int options;
+    // Full phase 1 pruning table
+    unique_ptr<Phase1PruningTable> phase1PruningTable;
+    // Phase 2 corner and edge pruning table
+    unique_ptr<Phase2PruningTable> phase2PruningTable;
+};
+
+#endif /* SolverTables_hpp */
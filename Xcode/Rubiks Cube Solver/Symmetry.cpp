@@ -0,0 +1,393 @@
+//
+//  Symmetry.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "Symmetry.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "FaceletCube.hpp"
+#include "RubiksCube.hpp"
+
+using namespace std;
+
+// A symmetry as an orthogonal 3x3 matrix acting on (x, y, z), where
+//   x points to R, y to U and z to F
+typedef int Matrix[3][3];
+
+static void MultiplyMatrices(const Matrix a, const Matrix b, Matrix result) {
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+            result[i][j] = 0;
+            for (int k = 0; k < 3; k++)
+                result[i][j] += a[i][k]*b[k][j];
+        }
+}
+
+static void Transform(const Matrix m, const int* vector, int* result) {
+    for (int i = 0; i < 3; i++)
+        result[i] = m[i][0]*vector[0] + m[i][1]*vector[1] + m[i][2]*vector[2];
+}
+
+// The generating symmetries
+static const Matrix Identity = {{1,0,0}, {0,1,0}, {0,0,1}};
+static const Matrix URF3 = {{0,1,0}, {0,0,1}, {1,0,0}};		// U to R, R to F, F to U
+static const Matrix F2 = {{-1,0,0}, {0,-1,0}, {0,0,1}};		// Half turn about F-B
+static const Matrix U4 = {{0,0,-1}, {0,1,0}, {1,0,0}};		// R to F, F to L (like U)
+static const Matrix LR2 = {{-1,0,0}, {0,1,0}, {0,0,1}};		// Swaps L and R
+
+struct Symmetry::Tables {
+    Tables(void);
+    
+    Matrix matrix[NumberOfSymmetries];
+    int multiply[NumberOfSymmetries][NumberOfSymmetries];
+    int inverse[NumberOfSymmetries];
+    bool mirror[NumberOfSymmetries];
+    int move[NumberOfSymmetries][Cube::NumberOfMoves];
+    
+    // Where each cubicle (and cubie) goes, and what becomes of the
+    //   orientation of cubie j in cubicle i
+    int cornerCubicle[NumberOfSymmetries][Cube::NumberOfCornerCubies];
+    int cornerOrientation[NumberOfSymmetries][Cube::NumberOfCornerCubies][Cube::NumberOfCornerCubies][3];
+    int edgeCubicle[NumberOfSymmetries][Cube::NumberOfEdgeCubies];
+    int edgeOrientation[NumberOfSymmetries][Cube::NumberOfEdgeCubies][Cube::NumberOfEdgeCubies][2];
+};
+
+// FaceletCube lays out its facelets on a net (see FaceletCube.cpp).
+//   Here each facelet is given the position of its cubie and the
+//   direction it faces, so that a symmetry can be applied to it.
+static void FaceletGeometry(int facelet, int* position, int* normal) {
+    int face = facelet/FACELETS_PER_FACE;
+    int row = facelet%FACELETS_PER_FACE/3;
+    int column = facelet%3;
+    int x = 0, y = 0, z = 0;
+    
+    normal[0] = normal[1] = normal[2] = 0;
+    switch (face) {
+        case FaceletCube::U: y = 1;  x = column-1; z = row-1;   normal[1] = 1;  break;
+        case FaceletCube::D: y = -1; x = column-1; z = 1-row;   normal[1] = -1; break;
+        case FaceletCube::L: x = -1; y = 1-row;    z = column-1; normal[0] = -1; break;
+        case FaceletCube::R: x = 1;  y = 1-row;    z = 1-column; normal[0] = 1;  break;
+        case FaceletCube::F: z = 1;  y = 1-row;    x = column-1; normal[2] = 1;  break;
+        case FaceletCube::B: z = -1; y = 1-row;    x = 1-column; normal[2] = -1; break;
+    }
+    position[0] = x; position[1] = y; position[2] = z;
+}
+
+// The facelet a symmetry moves a facelet to
+static int TransformFacelet(const Matrix m, int facelet) {
+    int position[3], normal[3], position2[3], normal2[3];
+    int p[3], n[3];
+    
+    FaceletGeometry(facelet, position, normal);
+    Transform(m, position, position2);
+    Transform(m, normal, normal2);
+    for (int other = 0; other < NUM_FACELETS; other++) {
+        FaceletGeometry(other, p, n);
+        if (!memcmp(p, position2, sizeof(p)) && !memcmp(n, normal2, sizeof(n)))
+            return other;
+    }
+    return -1;	// Not reached
+}
+
+Symmetry::Tables::Tables(void) {
+    int symmetry, other;
+    
+    // Build each symmetry from its factors
+    for (int urf3 = 0; urf3 < 3; urf3++)
+        for (int f2 = 0; f2 < 2; f2++)
+            for (int u4 = 0; u4 < 4; u4++)
+                for (int lr2 = 0; lr2 < 2; lr2++) {
+                    Matrix m, t;
+                    memcpy(m, Identity, sizeof(m));
+                    for (int i = 0; i < urf3; i++) { MultiplyMatrices(m, URF3, t); memcpy(m, t, sizeof(m)); }
+                    for (int i = 0; i < f2; i++)   { MultiplyMatrices(m, F2, t);   memcpy(m, t, sizeof(m)); }
+                    for (int i = 0; i < u4; i++)   { MultiplyMatrices(m, U4, t);   memcpy(m, t, sizeof(m)); }
+                    for (int i = 0; i < lr2; i++)  { MultiplyMatrices(m, LR2, t);  memcpy(m, t, sizeof(m)); }
+                    memcpy(matrix[Index(urf3, f2, u4, lr2)], m, sizeof(m));
+                }
+    
+    // Group structure
+    for (symmetry = 0; symmetry < NumberOfSymmetries; symmetry++) {
+        const Matrix& m = matrix[symmetry];
+        mirror[symmetry] = m[0][0]*(m[1][1]*m[2][2]-m[1][2]*m[2][1])
+                         - m[0][1]*(m[1][0]*m[2][2]-m[1][2]*m[2][0])
+                         + m[0][2]*(m[1][0]*m[2][1]-m[1][1]*m[2][0]) < 0;
+        for (other = 0; other < NumberOfSymmetries; other++) {
+            Matrix product;
+            // first, then second: the second matrix acts last
+            MultiplyMatrices(matrix[other], m, product);
+            for (int result = 0; result < NumberOfSymmetries; result++)
+                if (!memcmp(product, matrix[result], sizeof(product)))
+                    multiply[symmetry][other] = result;
+        }
+    }
+    for (symmetry = 0; symmetry < NumberOfSymmetries; symmetry++)
+        for (other = 0; other < NumberOfSymmetries; other++)
+            if (multiply[symmetry][other] == 0)
+                inverse[symmetry] = other;
+    
+    for (symmetry = 0; symmetry < NumberOfSymmetries; symmetry++) {
+        const Matrix& m = matrix[symmetry];
+        int facelet[NUM_FACELETS];	// Where each facelet goes
+        int face[NUM_FACES];		// What each face (and colour) becomes
+        for (int f = 0; f < NUM_FACELETS; f++)
+            facelet[f] = TransformFacelet(m, f);
+        for (int f = 0; f < NUM_FACES; f++)
+            face[f] = facelet[f*FACELETS_PER_FACE+4]/FACELETS_PER_FACE;
+    
+        // Place cubie j in cubicle i with orientation o, move its
+        //   facelets, recolour them and read the cubicle they land in
+        for (int i = 0; i < Cube::NumberOfCornerCubies; i++) {
+            int target[3];
+            for (int t = 0; t < 3; t++)
+                target[t] = facelet[FaceletCube::cornerFacelets[i][t]];
+            for (int i2 = 0; i2 < Cube::NumberOfCornerCubies; i2++)
+                for (int t = 0; t < 3; t++)
+                    if (FaceletCube::cornerFacelets[i2][0] == target[t])
+                        cornerCubicle[symmetry][i] = i2;
+            int i2 = cornerCubicle[symmetry][i];
+            for (int j = 0; j < Cube::NumberOfCornerCubies; j++)
+                for (int o = 0; o < 3; o++) {
+                    int colour = FaceletCube::cornerMap[3*j+o];
+                    int colours[3] = { colour/36, colour/6%6, colour%6 };
+                    int read[3] = { 0, 0, 0 };	// Every facelet is found, but the compiler can not tell
+                    for (int u = 0; u < 3; u++)
+                        for (int t = 0; t < 3; t++)
+                            if (target[t] == FaceletCube::cornerFacelets[i2][u])
+                                read[u] = face[colours[t]];
+                    int cubie = FacesToCorner(read[0], read[1], read[2]);
+                    for (int k = 0; k < Cube::NumberOfCornerCubies*3; k++)
+                        if (FaceletCube::cornerMap[k] == cubie)
+                            cornerOrientation[symmetry][i][j][o] = k%3;
+                }
+        }
+        for (int i = 0; i < Cube::NumberOfEdgeCubies; i++) {
+            int target[2];
+            for (int t = 0; t < 2; t++)
+                target[t] = facelet[FaceletCube::edgeFacelets[i][t]];
+            for (int i2 = 0; i2 < Cube::NumberOfEdgeCubies; i2++)
+                for (int t = 0; t < 2; t++)
+                    if (FaceletCube::edgeFacelets[i2][0] == target[t])
+                        edgeCubicle[symmetry][i] = i2;
+            int i2 = edgeCubicle[symmetry][i];
+            for (int j = 0; j < Cube::NumberOfEdgeCubies; j++)
+                for (int o = 0; o < 2; o++) {
+                    int colour = FaceletCube::edgeMap[2*j+o];
+                    int colours[2] = { colour/6, colour%6 };
+                    int read[2] = { 0, 0 };
+                    for (int u = 0; u < 2; u++)
+                        for (int t = 0; t < 2; t++)
+                            if (target[t] == FaceletCube::edgeFacelets[i2][u])
+                                read[u] = face[colours[t]];
+                    int cubie = FacesToEdge(read[0], read[1]);
+                    for (int k = 0; k < Cube::NumberOfEdgeCubies*2; k++)
+                        if (FaceletCube::edgeMap[k] == cubie)
+                            edgeOrientation[symmetry][i][j][o] = k%2;
+                }
+        }
+    
+        // Moves follow their face, and turn the other way in a mirror
+        static const int moveFace[Cube::NumberOfClockwiseQuarterTurnMoves] = {
+            FaceletCube::R, FaceletCube::L, FaceletCube::U, FaceletCube::D, FaceletCube::F, FaceletCube::B
+        };
+        for (int move = Cube::FirstMove; move <= Cube::LastMove; move++) {
+            int turn = move/Cube::NumberOfClockwiseQuarterTurnMoves;	// 0 = clockwise, 1 = anti, 2 = half
+            int f = face[moveFace[move%Cube::NumberOfClockwiseQuarterTurnMoves]];
+            int move2 = 0;
+            while (moveFace[move2] != f) move2++;
+            if (mirror[symmetry] && turn < 2) turn = 1-turn;
+            this->move[symmetry][move] = move2 + turn*Cube::NumberOfClockwiseQuarterTurnMoves;
+        }
+    }
+}
+
+const Symmetry::Tables& Symmetry::TheTables(void) {
+    static const Tables tables;	// Built on first use (thread safe)
+    return tables;
+}
+
+int Symmetry::Multiply(int first, int second) {
+    return TheTables().multiply[first][second];
+}
+
+int Symmetry::Inverse(int symmetry) {
+    return TheTables().inverse[symmetry];
+}
+
+bool Symmetry::IsMirror(int symmetry) {
+    return TheTables().mirror[symmetry];
+}
+
+int Symmetry::ConjugateMove(int move, int symmetry) {
+    return TheTables().move[symmetry][move];
+}
+
+void Symmetry::Conjugate(const Cube& cube, int symmetry, Cube& result) {
+    const Tables& t = TheTables();
+    int cornerPermutation[Cube::NumberOfCornerCubies], cornerOrientation[Cube::NumberOfCornerCubies];
+    int edgePermutation[Cube::NumberOfEdgeCubies], edgeOrientation[Cube::NumberOfEdgeCubies];
+    int cornerPermutation2[Cube::NumberOfCornerCubies], cornerOrientation2[Cube::NumberOfCornerCubies];
+    int edgePermutation2[Cube::NumberOfEdgeCubies], edgeOrientation2[Cube::NumberOfEdgeCubies];
+    
+    cube.GetState(cornerPermutation, cornerOrientation, edgePermutation, edgeOrientation);
+    for (int i = 0; i < Cube::NumberOfCornerCubies; i++) {
+        int j = cornerPermutation[i];
+        cornerPermutation2[t.cornerCubicle[symmetry][i]] = t.cornerCubicle[symmetry][j];
+        cornerOrientation2[t.cornerCubicle[symmetry][i]] = t.cornerOrientation[symmetry][i][j][cornerOrientation[i]];
+    }
+    for (int i = 0; i < Cube::NumberOfEdgeCubies; i++) {
+        int j = edgePermutation[i];
+        edgePermutation2[t.edgeCubicle[symmetry][i]] = t.edgeCubicle[symmetry][j];
+        edgeOrientation2[t.edgeCubicle[symmetry][i]] = t.edgeOrientation[symmetry][i][j][edgeOrientation[i]];
+    }
+    result.SetState(cornerPermutation2, cornerOrientation2, edgePermutation2, edgeOrientation2);
+}
+
+int Symmetry::ConjugateFlipSlice(int flipSlice, int symmetry) {
+    RubiksCube cube;
+    int cornerPermutation[Cube::NumberOfCornerCubies], cornerOrientation[Cube::NumberOfCornerCubies];
+    int edgePermutation[Cube::NumberOfEdgeCubies], edgeOrientation[Cube::NumberOfEdgeCubies];
+    
+    // Any cube with this flip and choice will do: fill the cubicles
+    //   not holding a middle slice edge with the other edges in order
+    cube.Choice(flipSlice%RubiksCube::Choices);
+    cube.Flip(flipSlice/RubiksCube::Choices);
+    cube.GetState(cornerPermutation, cornerOrientation, edgePermutation, edgeOrientation);
+    for (int i = 0, edge = Cube::FirstEdgeCubie; i < Cube::NumberOfEdgeCubies; i++)
+        if (edgePermutation[i] == Cube::InvalidCubie)
+            edgePermutation[i] = edge++;
+    cube.SetState(cornerPermutation, cornerOrientation, edgePermutation, edgeOrientation);
+    
+    Conjugate(cube, symmetry, cube);
+    return cube.Flip()*RubiksCube::Choices + cube.Choice();
+}
+
+// The conjugates of a coordinate under the UD symmetries, for a
+//   coordinate that the conjugates depend on alone
+struct Symmetry::ConjugateTable {
+    ConjugateTable(int size, void (RubiksCube::*set)(int), int (RubiksCube::*get)(void));
+    
+    vector<uint16_t> conjugate;		// [coordinate*NumberOfUDSymmetries+symmetry]
+};
+
+Symmetry::ConjugateTable::ConjugateTable(int size, void (RubiksCube::*set)(int), int (RubiksCube::*get)(void))
+: conjugate(size*NumberOfUDSymmetries) {
+    RubiksCube cube;
+    for (int coordinate = 0; coordinate < size; coordinate++)
+        for (int symmetry = 0; symmetry < NumberOfUDSymmetries; symmetry++) {
+            // Start from home as some coordinates only set part of the cube
+            cube.BackToHome();
+            (cube.*set)(coordinate);
+            Conjugate(cube, symmetry, cube);
+            conjugate[coordinate*NumberOfUDSymmetries+symmetry] = (cube.*get)();
+        }
+}
+
+const Symmetry::ConjugateTable& Symmetry::TheTwistTable(void) {
+    static const ConjugateTable table(Twists, &RubiksCube::Twist, &RubiksCube::Twist);	// Built on first use (thread safe)
+    return table;
+}
+
+const Symmetry::ConjugateTable& Symmetry::TheCornerPermutationTable(void) {
+    static const ConjugateTable table(CornerPermutations, &RubiksCube::CornerPermutation, &RubiksCube::CornerPermutation);
+    return table;
+}
+
+const Symmetry::ConjugateTable& Symmetry::TheNonMiddleSliceEdgePermutationTable(void) {
+    static const ConjugateTable table(NonMiddleSliceEdgePermutations,
+                                      &RubiksCube::NonMiddleSliceEdgePermutation, &RubiksCube::NonMiddleSliceEdgePermutation);
+    return table;
+}
+
+int Symmetry::ConjugateTwist(int twist, int symmetry) {
+    return TheTwistTable().conjugate[twist*NumberOfUDSymmetries+symmetry];
+}
+
+int Symmetry::ConjugateCornerPermutation(int cornerPermutation, int symmetry) {
+    return TheCornerPermutationTable().conjugate[cornerPermutation*NumberOfUDSymmetries+symmetry];
+}
+
+int Symmetry::ConjugateNonMiddleSliceEdgePermutation(int nonMiddleSliceEdgePermutation, int symmetry) {
+    return TheNonMiddleSliceEdgePermutationTable().conjugate[nonMiddleSliceEdgePermutation*NumberOfUDSymmetries+symmetry];
+}
+
+// The classes of a coordinate under the UD symmetries
+struct Symmetry::ClassTable {
+    ClassTable(int size, int (*conjugate)(int coordinate, int symmetry));
+    
+    vector<uint16_t> classOf;		// Class of each coordinate
+    vector<uint8_t> symmetryOf;		// Symmetry taking it to its representative
+    vector<int> representative;		// Representative of each class
+    vector<uint16_t> stabilizer;	// Symmetries fixing each representative
+};
+
+Symmetry::ClassTable::ClassTable(int size, int (*conjugate)(int coordinate, int symmetry))
+: classOf(size, 0xffff), symmetryOf(size) {
+    // Coordinates are visited in ascending order, so each class is
+    //   represented by its smallest coordinate
+    for (int coordinate = 0; coordinate < size; coordinate++) {
+        if (classOf[coordinate] != 0xffff)
+            continue;
+        int coordinateClass = (int)representative.size();
+        unsigned int mask = 0;
+        for (int symmetry = 0; symmetry < NumberOfUDSymmetries; symmetry++) {
+            int other = conjugate(coordinate, symmetry);
+            if (other == coordinate)
+                mask |= 1 << symmetry;
+            if (classOf[other] == 0xffff) {
+                classOf[other] = coordinateClass;
+                symmetryOf[other] = Inverse(symmetry);
+            }
+        }
+        representative.push_back(coordinate);
+        stabilizer.push_back(mask);
+    }
+}
+
+const Symmetry::ClassTable& Symmetry::TheFlipSliceClasses(void) {
+    static const ClassTable table(FlipSlices, ConjugateFlipSlice);	// Built on first use (thread safe)
+    return table;
+}
+
+const Symmetry::ClassTable& Symmetry::TheCornerPermutationClasses(void) {
+    static const ClassTable table(CornerPermutations, ConjugateCornerPermutation);
+    return table;
+}
+
+int Symmetry::FlipSliceClass(int flipSlice) {
+    return TheFlipSliceClasses().classOf[flipSlice];
+}
+
+int Symmetry::FlipSliceSymmetry(int flipSlice) {
+    return TheFlipSliceClasses().symmetryOf[flipSlice];
+}
+
+int Symmetry::FlipSliceRepresentative(int flipSliceClass) {
+    return TheFlipSliceClasses().representative[flipSliceClass];
+}
+
+unsigned int Symmetry::FlipSliceStabilizer(int flipSliceClass) {
+    return TheFlipSliceClasses().stabilizer[flipSliceClass];
+}
+
+int Symmetry::CornerPermutationClass(int cornerPermutation) {
+    return TheCornerPermutationClasses().classOf[cornerPermutation];
+}
+
+int Symmetry::CornerPermutationSymmetry(int cornerPermutation) {
+    return TheCornerPermutationClasses().symmetryOf[cornerPermutation];
+}
+
+int Symmetry::CornerPermutationRepresentative(int cornerPermutationClass) {
+    return TheCornerPermutationClasses().representative[cornerPermutationClass];
+}
+
+unsigned int Symmetry::CornerPermutationStabilizer(int cornerPermutationClass) {
+    return TheCornerPermutationClasses().stabilizer[cornerPermutationClass];
+}
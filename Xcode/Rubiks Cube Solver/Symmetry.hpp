@@ -0,0 +1,117 @@
+//
+//  Symmetry.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef Symmetry_hpp
+#define Symmetry_hpp
+
+//
+// The 48 symmetries of the cube (its rotations and reflections)
+// and the symmetry reduced coordinates built on them.
+//
+// A symmetry is applied to a cube by conjugation: the whole cube
+// is turned (or mirrored) in space and its facelets are then
+// recoloured so that the centres are back where they started.
+// Two cubes related in this way are the same distance from home,
+// so a pruning table need only hold one entry for each class of
+// equivalent positions.
+//
+// Symmetries are numbered as in Kociemba's Cube Explorer:
+//
+//   16*urf3 + 8*f2 + 2*u4 + lr2
+//
+// for the symmetry URF3^urf3 F2^f2 U4^u4 LR2^lr2, where URF3 is a
+// 120 degree turn about the URF-DBL diagonal, F2 a half turn about
+// the F-B axis, U4 a quarter turn about the U-D axis and LR2 the
+// reflection through the plane between L and R.  The first 16
+// symmetries are those that leave the U-D axis in place.  These
+// preserve the phase 1 subgroup, and therefore the phase 1 goal.
+//
+// The tables used here are all built on first use, from the
+// geometry of the facelets (see FaceletCube).
+//
+
+#include <cstdint>
+
+#include "Cube.hpp"
+
+class Symmetry {
+public:
+    enum {
+        NumberOfSymmetries = 48,	// All rotations and reflections
+        NumberOfUDSymmetries = 16,	// Those preserving the U-D axis
+        Twists = 2187,			// As in TwistMoveTable
+        FlipSlices = 2048*495,		// Flip*Choices+choice
+        FlipSliceClasses = 64430,	// FlipSlice classes under the UD symmetries
+        CornerPermutations = 40320,	// As in CornerPermutationMoveTable
+        CornerPermutationClasses = 2768,	// CornerPermutation classes under the UD symmetries
+        NonMiddleSliceEdgePermutations = 40320	// As in NonMiddleSliceEdgePermutationMoveTable
+    };
+    
+    // The number of a symmetry given its factors
+    static int Index(int urf3, int f2, int u4, int lr2) {
+        return 16*urf3 + 8*f2 + 2*u4 + lr2;
+    }
+    
+    // The symmetry equivalent to applying first and then second, i.e.
+    //   Conjugate(Conjugate(c, first), second) == Conjugate(c, Multiply(first, second))
+    static int Multiply(int first, int second);
+    // The symmetry undoing symmetry
+    static int Inverse(int symmetry);
+    // Whether a symmetry is a reflection
+    static bool IsMirror(int symmetry);
+    
+    // Apply a symmetry to a cube
+    static void Conjugate(const Cube& cube, int symmetry, Cube& result);
+    
+    // The move that corresponds to move on the conjugated cube, so
+    //   that applying move and then conjugating gives the same cube
+    //   as conjugating and then applying ConjugateMove(move, symmetry)
+    static int ConjugateMove(int move, int symmetry);
+    
+    // Apply a UD symmetry to a Twist, CornerPermutation or (phase 2)
+    //   NonMiddleSliceEdgePermutation coordinate.  The coordinate of
+    //   the conjugated cube depends on the coordinate alone.
+    static int ConjugateTwist(int twist, int symmetry);
+    static int ConjugateCornerPermutation(int cornerPermutation, int symmetry);
+    static int ConjugateNonMiddleSliceEdgePermutation(int nonMiddleSliceEdgePermutation, int symmetry);
+    
+    // FlipSlice sym-coordinate (flip*Choices+choice, reduced by the
+    //   16 UD symmetries)
+    
+    // Apply a UD symmetry to a FlipSlice coordinate
+    static int ConjugateFlipSlice(int flipSlice, int symmetry);
+    // The class of a FlipSlice coordinate
+    static int FlipSliceClass(int flipSlice);
+    // The symmetry taking a FlipSlice coordinate to its class representative
+    static int FlipSliceSymmetry(int flipSlice);
+    // The (smallest) FlipSlice coordinate of a class
+    static int FlipSliceRepresentative(int flipSliceClass);
+    // The UD symmetries (as a bit mask) leaving a class representative unchanged
+    static unsigned int FlipSliceStabilizer(int flipSliceClass);
+    
+    // CornerPermutation sym-coordinate (reduced by the 16 UD
+    //   symmetries, as above)
+    static int CornerPermutationClass(int cornerPermutation);
+    static int CornerPermutationSymmetry(int cornerPermutation);
+    static int CornerPermutationRepresentative(int cornerPermutationClass);
+    static unsigned int CornerPermutationStabilizer(int cornerPermutationClass);
+    
+private:
+    // Symmetry tables (see Symmetry.cpp)
+    struct Tables;
+    struct ConjugateTable;
+    struct ClassTable;
+    static const Tables& TheTables(void);
+    static const ConjugateTable& TheTwistTable(void);
+    static const ConjugateTable& TheCornerPermutationTable(void);
+    static const ConjugateTable& TheNonMiddleSliceEdgePermutationTable(void);
+    static const ClassTable& TheFlipSliceClasses(void);
+    static const ClassTable& TheCornerPermutationClasses(void);
+};
+
+#endif /* Symmetry_hpp */
@@ -0,0 +1,249 @@
+//
+//  TableBundle.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "TableBundle.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+
+#include "RubiksCube.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// The start of the file
+struct TableBundle::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t variant;		// Choice coordinate variant (see below)
+    uint32_t numberOfTables;	// Catalogue entries following the header
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+// One catalogue entry
+struct TableBundle::Entry {
+    char name[MaximumNameLength+1];	// Null terminated
+    uint64_t entries;
+    uint64_t offset;		// A multiple of PageSize
+    uint64_t size;
+    uint64_t checksum;
+};
+
+static const char Magic[8] = { 'R', 'u', 'b', 'i', 'k', 'T', 'b', 'l' };
+
+enum {
+    Kociemba = 1,		// Choice coordinate variants
+    Winter = 2,
+#ifdef KOCIEMBA
+    Variant = Kociemba
+#else
+    Variant = Winter
+#endif
+};
+
+static const size_t ChunkSize = 1<<20;	// Bytes checksummed by each task
+
+static const uint64_t Prime1 = 0x9e3779b185ebca87ULL;
+static const uint64_t Prime2 = 0xc2b2ae3d27d4eb4fULL;
+
+static inline uint64_t Rotate(uint64_t value, int bits) {
+    return (value<<bits) | (value>>(64-bits));
+}
+
+static inline uint64_t Mix(uint64_t hash) {
+    hash ^= hash>>33;
+    hash *= Prime2;
+    hash ^= hash>>29;
+    hash *= Prime1;
+    return hash^(hash>>32);
+}
+
+// Checksum one chunk of a table, in the manner of xxHash: four
+//   independent lanes each take a word of every 32 bytes, so the
+//   multiplies overlap rather than waiting on one another
+static uint64_t ChunkChecksum(const unsigned char* data, size_t size, uint64_t seed) {
+    uint64_t lane[4] = { seed+Prime1, seed+Prime2, seed, seed-Prime1 };
+    uint64_t word;
+    uint64_t hash;
+    size_t offset;
+    int i;
+    
+    for (offset = 0; offset+32 <= size; offset += 32) {
+        for (i = 0; i < 4; i++) {
+            memcpy(&word, data+offset+8*i, sizeof(word));
+            lane[i] = Rotate(lane[i]+word*Prime2, 31)*Prime1;
+        }
+    }
+    hash = Rotate(lane[0], 1) + Rotate(lane[1], 7) + Rotate(lane[2], 12) + Rotate(lane[3], 18);
+    // Any bytes left over
+    for (; offset < size; offset++)
+        hash = Rotate(hash^(data[offset]*Prime1), 11)*Prime2;
+    return Mix(hash+size);
+}
+
+vector<uint64_t> TableBundle::Checksums(const vector<Image>& images) {
+    vector<vector<future<uint64_t> > > chunks(images.size());
+    vector<uint64_t> checksums(images.size());
+    size_t image;
+    size_t offset;
+    
+    // Checksum every chunk of every table in parallel...
+    ThreadPool pool;
+    for (image = 0; image < images.size(); image++) {
+        const unsigned char* data = (const unsigned char*)images[image].data;
+        size_t size = images[image].size;
+        for (offset = 0; offset < size || offset == 0; offset += ChunkSize) {
+            size_t length = size-offset < ChunkSize ? size-offset : ChunkSize;
+            uint64_t seed = offset/ChunkSize;
+            chunks[image].push_back(pool.Submit([data, offset, length, seed]() {
+                return ChunkChecksum(data+offset, length, seed);
+            }));
+        }
+    }
+    // ...then combine each table's chunks in order
+    for (image = 0; image < images.size(); image++) {
+        uint64_t checksum = images[image].size;
+        for (size_t chunk = 0; chunk < chunks[image].size(); chunk++)
+            checksum = Mix(checksum*Prime1 + chunks[image][chunk].get());
+        checksums[image] = checksum;
+    }
+    return checksums;
+}
+
+TableBundle::TableBundle(void) {}
+
+bool TableBundle::Open(const char* fileName) {
+    Close();
+    
+    // Every page is about to be read for the checksums
+    if (!File.Open(fileName, 0, MappedFile::Sequential))
+        return false;
+    if (!Attach((const unsigned char*)File.Address(), File.SizeOf(), true)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool TableBundle::Open(const void* image, size_t size) {
+    Close();
+    return Attach((const unsigned char*)image, size, false);
+}
+
+bool TableBundle::Attach(const unsigned char* base, size_t size, bool verify) {
+    const Header* header;
+    const Entry* entry;
+    vector<Image> candidates;
+    vector<uint64_t> expected;
+    uint32_t table;
+    
+    // Check the header
+    header = (const Header*)base;
+    if (size < sizeof(Header) ||
+        memcmp(header->magic, Magic, sizeof(Magic)) != 0 ||
+        header->version != Version ||
+        header->variant != Variant ||
+        header->fileSize != size ||
+        header->numberOfTables > (size-sizeof(Header))/sizeof(Entry))
+        return false;
+    
+    // Collect the catalogue entries that fit within the file
+    entry = (const Entry*)(header+1);
+    for (table = 0; table < header->numberOfTables; table++, entry++) {
+        if (memchr(entry->name, 0, sizeof(entry->name)) == 0 ||
+            entry->offset%PageSize != 0 ||
+            entry->offset > size || entry->size > size-entry->offset)
+            continue;
+        candidates.push_back(Image(entry->name, (int)entry->entries, base+entry->offset, (size_t)entry->size));
+        expected.push_back(entry->checksum);
+    }
+    
+    // Keep the tables whose contents match their checksums
+    if (!verify) {
+        Tables = candidates;
+        return true;
+    }
+    vector<uint64_t> checksums = Checksums(candidates);
+    for (size_t image = 0; image < candidates.size(); image++) {
+        if (checksums[image] == expected[image])
+            Tables.push_back(candidates[image]);
+    }
+    return true;
+}
+
+void TableBundle::Close(void) {
+    Tables.clear();
+    File.Close();
+}
+
+const void* TableBundle::Find(const char* name, int entries, size_t size, MappedFile::Access access) {
+    for (size_t table = 0; table < Tables.size(); table++) {
+        const Image& image = Tables[table];
+        if (image.name != name)
+            continue;
+        if (image.entries != entries || image.size != size)
+            return 0;
+        if (File.IsOpen())
+            File.Advise((const unsigned char*)image.data-(const unsigned char*)File.Address(), size, access);
+        return image.data;
+    }
+    return 0;
+}
+
+bool TableBundle::Save(const char* fileName, const vector<Image>& images) {
+    static const char padding[PageSize] = { 0 };
+    vector<uint64_t> checksums = Checksums(images);
+    vector<Entry> entries(images.size());
+    Header header;
+    uint64_t offset;
+    size_t table;
+    
+    // Lay out the tables, each on a page boundary after the catalogue
+    offset = sizeof(Header)+images.size()*sizeof(Entry);
+    for (table = 0; table < images.size(); table++) {
+        Entry& entry = entries[table];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, images[table].name.c_str(), MaximumNameLength);
+        entry.entries = images[table].entries;
+        entry.offset = (offset+PageSize-1)/PageSize*PageSize;
+        entry.size = images[table].size;
+        entry.checksum = checksums[table];
+        offset = entry.offset+entry.size;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.variant = Variant;
+    header.numberOfTables = (uint32_t)images.size();
+    header.fileSize = offset;
+    
+    // Write it all alongside the bundle...
+    string temporaryName = string(fileName)+".tmp";
+    {
+        ofstream outfile(temporaryName.c_str(), ios::out|ios::binary|ios::trunc);
+        outfile.write((const char*)&header, sizeof(header));
+        if (!entries.empty())
+            outfile.write((const char*)&entries[0], entries.size()*sizeof(Entry));
+        offset = sizeof(Header)+entries.size()*sizeof(Entry);
+        for (table = 0; table < images.size(); table++) {
+            outfile.write(padding, entries[table].offset-offset);
+            outfile.write((const char*)images[table].data, images[table].size);
+            offset = entries[table].offset+entries[table].size;
+        }
+        outfile.close();
+        if (!outfile) {
+            remove(temporaryName.c_str());
+            return false;
+        }
+    }
+    // ...and only then replace it
+    return rename(temporaryName.c_str(), fileName) == 0;
+}
@@ -0,0 +1,106 @@
+//
+//  TableBundle.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef TableBundle_hpp
+#define TableBundle_hpp
+
+//
+// A single file holding every move mapping and pruning table.
+//
+// The file begins with a header identifying the format, its
+// version and the choice coordinate variant (Kociemba's or Dik
+// Winter's, see RubiksCube.hpp) the tables were generated with,
+// followed by a catalogue giving each table's name, number of
+// entries (its coordinate size), offset, length and checksum.
+// Each table starts on a page boundary, so the search indexes
+// straight into the mapped file, as it did with the loose files.
+//
+// When the bundle is opened every table's checksum is verified,
+// in parallel.  A table that is missing, of the wrong size or
+// fails its checksum is simply not found, and will be generated
+// and saved again.  A bundle of another version or variant is
+// ignored altogether.  Numbers are stored in the byte order of
+// the machine that wrote them, so a bundle from a machine of
+// the other order is ignored as well.
+//
+// A bundle may also be built into the executable (see
+// EmbeddedTables.hpp), in which case only its header is checked.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+using namespace std;
+
+class TableBundle {
+public:
+    enum {
+        Version = 1,		// Bumped whenever any table's layout changes
+        PageSize = 16384,	// Tables are aligned to the largest page size in common use
+        MaximumNameLength = 15	// Longest table name
+    };
+    
+    // A table to be saved (or found in the bundle)
+    struct Image {
+        Image(const string& name, int entries, const void* data, size_t size)
+        : name(name), entries(entries), data(data), size(size) {}
+        string name;
+        int entries;		// Number of logical entries
+        const void* data;
+        size_t size;		// In bytes
+    };
+    
+    TableBundle(void);
+    
+    // Map a bundle and verify its tables.  Returns false if the
+    //   file is absent or is not a usable bundle.
+    bool Open(const char* fileName);
+    // Use a bundle that is already in memory.  Only the header is
+    //   checked, so that none of the tables need be read.
+    bool Open(const void* image, size_t size);
+    
+    // Unmap the bundle
+    void Close(void);
+    
+    // Find a verified table, which must have the given number of
+    //   entries and size.  Returns its address, or 0 if there is
+    //   no such table, in which case it must be generated.
+    const void* Find(const char* name, int entries, size_t size, MappedFile::Access access);
+    
+    // The verified tables of the bundle
+    const vector<Image>& Catalogue(void) const { return Tables; }
+    
+    // Write a bundle holding the given tables.  The bundle is
+    //   written alongside and then renamed into place, so a bundle
+    //   that is mapped (even this one) is not disturbed.
+    static bool Save(const char* fileName, const vector<Image>& images);
+    
+private:
+    // The bundle can not be copied
+    TableBundle(const TableBundle&);
+    TableBundle& operator=(const TableBundle&);
+    
+    // The on-disk layout (see TableBundle.cpp)
+    struct Header;
+    struct Entry;
+    
+    // Read the header and catalogue of a bundle, verifying the
+    //   tables' checksums if asked to
+    bool Attach(const unsigned char* base, size_t size, bool verify);
+    // Checksum a number of tables in parallel
+    static vector<uint64_t> Checksums(const vector<Image>& images);
+    
+    MappedFile File;
+    vector<Image> Tables;
+};
+
+#endif /* TableBundle_hpp */
@@ -0,0 +1,107 @@
+//
+//  ThreadPool.cpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// The pool and queue index of the current thread if it is a worker
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int numberOfThreads)
+: pending(0), nextQueue(0), stopping(false) {
+    if (numberOfThreads <= 0)
+        numberOfThreads = (int)thread::hardware_concurrency();
+    if (numberOfThreads <= 0)
+        numberOfThreads = 1;
+
+    for (int worker = 0; worker < numberOfThreads; worker++)
+        queues.push_back(unique_ptr<WorkQueue>(new WorkQueue));
+    for (int worker = 0; worker < numberOfThreads; worker++)
+        workers.push_back(thread(&ThreadPool::WorkerLoop, this, worker));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(idleLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t worker = 0; worker < workers.size(); worker++)
+        workers[worker].join();
+}
+
+void ThreadPool::Push(function<void()> task) {
+    int queue;
+    // Keep work spawned by a worker local to that worker
+    if (currentPool == this)
+        queue = currentWorker;
+    else
+        queue = nextQueue++ % queues.size();
+
+    {
+        lock_guard<mutex> guard(queues[queue]->lock);
+        queues[queue]->tasks.push_back(task);
+    }
+    {
+        lock_guard<mutex> guard(idleLock);
+        pending++;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::Pop(int worker, function<void()> &task) {
+    int numberOfQueues = (int)queues.size();
+
+    // Newest task from our own queue first...
+    {
+        WorkQueue& own = *queues[worker];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            pending--;
+            return true;
+        }
+    }
+    // ...otherwise steal the oldest task of another worker
+    for (int i = 1; i < numberOfQueues; i++) {
+        WorkQueue& victim = *queues[(worker+i) % numberOfQueues];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+    function<void()> task;
+
+    currentPool = this;
+    currentWorker = worker;
+
+    for (;;) {
+        if (Pop(worker, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        // Nothing to do, sleep until more work arrives.  Remaining
+        //   tasks are always drained before the pool shuts down.
+        unique_lock<mutex> guard(idleLock);
+        wake.wait(guard, [this]() { return stopping || pending > 0; });
+        if (stopping && pending == 0)
+            return;
+    }
+}
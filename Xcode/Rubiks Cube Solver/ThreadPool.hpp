@@ -0,0 +1,83 @@
+//
+//  ThreadPool.hpp
+//  Rubiks Cube Solver
+//
+//  Created by Morris Chen on 2017-07-27.
+//  Copyright © 2017 Morris Chen. All rights reserved.
+//
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+//
+// A fixed size, work stealing thread pool.  Each worker owns a
+// queue of tasks.  A worker takes its own tasks from the back of
+// its queue (most recently submitted first, which keeps its caches
+// warm) and, once that runs dry, steals from the front of the
+// other workers' queues.  Tasks submitted from a worker thread go
+// to that worker's own queue; tasks submitted from any other thread
+// are dealt out round robin.
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+class ThreadPool {
+public:
+    // Number of threads defaults to the number of hardware threads
+    ThreadPool(int numberOfThreads = 0);
+    // Waits for all submitted tasks to complete
+    ~ThreadPool();
+
+    // Submit a task, the result of which can be obtained from
+    //   the returned future
+    template<class Function>
+    future<typename result_of<Function()>::type> Submit(Function function) {
+        typedef typename result_of<Function()>::type Result;
+        shared_ptr<packaged_task<Result()> > task(new packaged_task<Result()>(function));
+        future<Result> result = task->get_future();
+        Push([task]() { (*task)(); });
+        return result;
+    }
+
+    // Number of worker threads
+    int Size(void) const { return (int)workers.size(); }
+
+private:
+    // The pool can not be copied
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    // Queue a task
+    void Push(function<void()> task);
+    // Take a task from a worker's own queue, or steal one
+    bool Pop(int worker, function<void()> &task);
+    // The body of each worker thread
+    void WorkerLoop(int worker);
+
+    struct WorkQueue {
+        mutex lock;
+        deque<function<void()> > tasks;
+    };
+
+    vector<unique_ptr<WorkQueue> > queues;	// One per worker
+    vector<thread> workers;
+
+    mutex idleLock;				// Guards sleeping workers
+    condition_variable wake;			// Signalled when work arrives
+    atomic<int> pending;			// Number of queued tasks
+    atomic<unsigned int> nextQueue;		// Round robin submission
+    bool stopping;
+};
+
+#endif /* ThreadPool_hpp */
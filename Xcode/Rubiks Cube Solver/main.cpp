@@ -1,15 +1,251 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 #include "CubeParser.hpp"
 #include "FaceletCube.hpp"
 #include "RubiksCube.hpp"
 #include "Solver.hpp"
+#include "ThreadPool.hpp"
 
 using namespace std;
 
+// Wait for the solver's tables, if they are still being initialized,
+//   and report how long each one took, and whether those that were
+//   generated could be saved
+static void ReportTables(const Solver& solver) {
+    const vector<TableTiming>& timings = solver.Tables()->WaitForTables();
+    for (size_t table = 0; table < timings.size(); table++) {
+        cout << timings[table].name << ": " << timings[table].entries << " entries "
+        << (timings[table].generated ? "generated" : "loaded") << " in "
+        << fixed << setprecision(3) << timings[table].seconds*1000 << " ms" << endl;
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    if (!solver.Tables()->WaitForSave())
+        cout << "Unable to save " << SolverTables::BundleFileName << endl;
+}
+
+// Output a solution, separating its phase 1 and phase 2 moves
+static void PrintSolution(const SolveResult& result) {
+    for (int move = 0; move < result.length; move++) {
+        if (move == result.phase1Length)
+            cout << ". ";
+        cout << Cube::NameOfMove(result.moves[move]) << " ";
+    }
+    if (result.phase1Length == result.length)
+        cout << ". ";
+    cout << "(" << result.length << ") after "
+    << result.nodes << " nodes, " << result.solutionSeconds << " s" << endl;
+}
+
+// Solve every cube listed in a file, one cube per line given as the
+//   six facelet strings separated by white space, e.g.
+//     U:RWGGWRWWW D:YBGGYYBOW F:RRROBYRWW B:OOYOGROYY L:GWBGOBOYB R:GBYRRGOBB
+//   Each cube is given at most timeLimit seconds, and is done with
+//   as soon as a solution of targetLength moves (if given) is found.
+static int SolveFile(char* fileName, double timeLimit, int targetLength) {
+    // The tables are initialized while the file is read
+    Solver solver;
+    solver.InitializeTables();
+    
+    ifstream infile(fileName);
+    if (!infile) {
+        cout << "Unable to open " << fileName << endl;
+        return 1;
+    }
+    
+    vector<RubiksCube> cubes;
+    vector<int> lineNumbers;
+    string line;
+    for (int lineNumber = 1; getline(infile, line); lineNumber++) {
+        string faceletStrings[6];
+        istringstream fields(line);
+        int face = 0;
+        while (face < 6 && fields >> faceletStrings[face]) face++;
+        if (face == 0) continue;	// Blank line
+    
+        unsigned int status;
+        FaceletCube faceletCube;
+        CubeParser cubeParser;
+        RubiksCube cube;
+        if((status = cubeParser.parseFacelets(faceletStrings, faceletCube)) != CubeParser::VALID) {
+            cout << lineNumber << ": " << cubeParser.ErrorText(status) << endl;
+            continue;
+        }
+        if((status = faceletCube.Validate(cube)) != FaceletCube::VALID) {
+            cout << lineNumber << ": " << faceletCube.ErrorText(status) << endl;
+            continue;
+        }
+        cubes.push_back(cube);
+        lineNumbers.push_back(lineNumber);
+    }
+    
+    BatchOptions options;
+    options.limits.timeLimit = timeLimit;
+    options.limits.targetLength = targetLength;
+    vector<SolveResult> results = solver.SolveBatch(cubes, options);
+    ReportTables(solver);
+    
+    for (size_t i = 0; i < results.size(); i++) {
+        cout << lineNumbers[i] << ": ";
+        for (int move = 0; move < results[i].length; move++)
+            cout << Cube::NameOfMove(results[i].moves[move]) << " ";
+        cout << "(" << results[i].length << ")" << endl;
+    }
+    return 0;
+}
+
+// Measure the search speed, in nodes per second, with each of the
+//   optional sets of tables.  The same pseudo random cubes are
+//   solved with each set of tables, for timeLimit seconds apiece.
+static int Benchmark(double timeLimit) {
+    enum { NumberOfCubes = 8, ScrambleLength = 40 };
+    static const struct {
+        const char* name;
+        unsigned int options;
+    } configurations[] = {
+        { "Pairwise tables", 0 },
+        { "Full phase 1 table", SolverTables::FullPhase1Table },
+        { "Corner and edge phase 2 table", SolverTables::CornerAndEdgeTable },
+        { "Both", SolverTables::FullPhase1Table|SolverTables::CornerAndEdgeTable }
+    };
+    
+    vector<RubiksCube> cubes(NumberOfCubes);
+    srand(1);
+    for (size_t i = 0; i < cubes.size(); i++)
+        for (int move = 0; move < ScrambleLength; move++)
+            cubes[i].ApplyMove(rand()%Cube::NumberOfMoves);
+    
+    for (size_t configuration = 0; configuration < sizeof(configurations)/sizeof(configurations[0]); configuration++) {
+        Solver solver(SolverTables::Create(configurations[configuration].options));
+        // Time the search alone
+        solver.Tables()->WaitForTables();
+        long nodes = 0;
+        int length = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t i = 0; i < cubes.size(); i++) {
+            SearchContext context;
+            SolveOptions limits;
+            limits.timeLimit = timeLimit;
+            context.verbose = 0;
+            context.SetLimits(limits);
+            solver.Solve(cubes[i], context);
+            nodes += context.totalNodes;
+            length += context.MinSolutionLength();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+        cout << configurations[configuration].name << ": "
+        << nodes << " nodes in " << seconds << " s = "
+        << (long)(nodes/seconds) << " nodes/s, total length " << length << endl;
+    }
+    return 0;
+}
+
+// Whether the phase 1 goal can be reached from a position within
+//   depth moves, by a plain IDA* search over the pairwise tables
+//   (which only give a cost of 0 at the goal itself)
+static bool Phase1Reachable(const SolverTables& tables, int twist, int flip, int choice, int depth, int lastMove) {
+    int cost = tables.Phase1Cost(twist, flip, choice);
+    if (cost == 0)
+        return true;
+    if (cost > depth)
+        return false;
+    for (int move = Cube::Move::R; move <= Cube::Move::B; move++) {
+        if (move == lastMove)
+            continue;
+        int twist2 = twist, flip2 = flip, choice2 = choice;
+        for (int power = 1; power < 4; power++) {
+            twist2 = tables.TwistMoves()[twist2][move];
+            flip2 = tables.FlipMoves()[flip2][move];
+            choice2 = tables.ChoiceMoves()[choice2][move];
+            if (Phase1Reachable(tables, twist2, flip2, choice2, depth-1, move))
+                return true;
+        }
+    }
+    return false;
+}
+
+// Check the exact phase 1 distances given by the full phase 1 table
+//   against a plain IDA* search over the pairwise tables, for a number
+//   of pseudo random positions and a neighbour of each (whose distance
+//   is found from the position's, as the search does)
+static int Verify(int positions) {
+    enum { ScrambleLength = 40 };
+    SolverTables pairwise;
+    SolverTables full(SolverTables::FullPhase1Table);
+    pairwise.Initialize();
+    full.Initialize();
+    
+    int mismatches = 0;
+    srand(1);
+    for (int position = 0; position < positions; position++) {
+        RubiksCube cube;
+        for (int move = 0; move < ScrambleLength; move++)
+            cube.ApplyMove(rand()%Cube::NumberOfMoves);
+        int twist = cube.Twist(), flip = cube.Flip(), choice = cube.Choice();
+        int move = rand()%Cube::NumberOfClockwiseQuarterTurnMoves;
+        int twist2 = pairwise.TwistMoves()[twist][move];
+        int flip2 = pairwise.FlipMoves()[flip][move];
+        int choice2 = pairwise.ChoiceMoves()[choice][move];
+        
+        int distance = -1;
+        int cost = full.Phase1Cost(twist, flip, choice, distance);
+        int cost2 = full.Phase1Cost(twist2, flip2, choice2, distance);
+        int expected, expected2;
+        for (expected = 0; !Phase1Reachable(pairwise, twist, flip, choice, expected, -1); expected++) ;
+        for (expected2 = 0; !Phase1Reachable(pairwise, twist2, flip2, choice2, expected2, -1); expected2++) ;
+        if (cost != expected || cost2 != expected2) {
+            cout << "Position " << position << ": phase 1 distance " << cost << " (neighbour "
+            << cost2 << "), expected " << expected << " (" << expected2 << ")" << endl;
+            mismatches++;
+        }
+    }
+    cout << positions << " positions checked, " << mismatches << " mismatches" << endl;
+    return mismatches != 0;
+}
+
+// Generate the default set of tables and save them to a bundle,
+//   which the build then embeds in the executable (see
+//   EmbeddedTables.hpp)
+static int GenerateTables(char* fileName) {
+    SolverTables tables;
+    tables.Initialize();
+    if (!tables.Save(fileName)) {
+        cout << "Unable to save " << fileName << endl;
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     unsigned int status;
     
+    // Table generation: solver -generate <bundle>
+    if (argc > 2 && strcmp(argv[1], "-generate") == 0)
+        return GenerateTables(argv[2]);
+    
+    // Benchmark mode: solver -benchmark [seconds per cube]
+    if (argc > 1 && strcmp(argv[1], "-benchmark") == 0)
+        return Benchmark(argc > 2 ? atof(argv[2]) : 2.0);
+    
+    // Verification mode: solver -verify [positions]
+    if (argc > 1 && strcmp(argv[1], "-verify") == 0)
+        return Verify(argc > 2 ? atoi(argv[2]) : 100);
+    
+    // Batch mode: solver <file> [seconds per cube] [target length]
+    if (argc > 1)
+        return SolveFile(argv[1], argc > 2 ? atof(argv[2]) : 1.0, argc > 3 ? atoi(argv[3]) : 0);
+    
+    // The tables are initialized while the input is checked
+    Solver solver;
+    solver.InitializeTables();
+    
     string faceletStrings[6] = {
         "U:RWGGWRWWW", "D:YBGGYYBOW", "F:RRROBYRWW", "B:OOYOGROYY", "L:GWBGOBOYB", "R:GBYRRGOBB"
     };
@@ -31,10 +267,16 @@ int main(int argc, char *argv[]) {
     
     // Cube is in a valid configuration at this point
     
-    // Initialize tables and solve
-    Solver solver;
-    solver.InitializeTables();
-    solver.Solve(cube);
+    // Solve using every hardware thread, reporting the progress
+    //   of phase 1 and each better solution as it is found
+    ThreadPool pool;
+    SearchContext context;
+    SolveOptions options;
+    options.onImprovement = PrintSolution;
+    context.verbose = 1;
+    context.SetLimits(options);
+    solver.SolveParallel(cube, context, pool);
+    ReportTables(solver);
     
     return 0;
 }	